@@ -3,11 +3,12 @@ out vec4 FragColor;
 
 in vec3 colorData;
 in vec2 texCoord;
+flat in int textureLayer;
 
-uniform sampler2D texture2;
+uniform sampler2DArray blockTextures; // One layer per block type
 
 void main()
 {
-    FragColor = texture(texture2, texCoord);
+    FragColor = texture(blockTextures, vec3(texCoord, textureLayer));
     
 }
\ No newline at end of file
@@ -2,7 +2,8 @@
 out vec4 FragColor;
 
 in vec2 TextureCoord;
-uniform sampler2D texturein;
+uniform sampler2DArray blockTextures; // One layer per block type
+uniform int texturein;                // Layer of the block in this slot
 uniform int combine;
 
 
@@ -10,5 +11,5 @@ void main()
 {
     vec2 t = TextureCoord;
     combine == 1 ? t = vec2(TextureCoord.x + .05f, TextureCoord.y - .05f) : t = TextureCoord;
-    FragColor = texture(texturein, t); // If combine is 1 the shader will show it normally
+    FragColor = texture(blockTextures, vec3(t, texturein)); // If combine is 1 the shader will show it normally
 }
@@ -2,9 +2,12 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
+// Packed block: position inside its chunk (cube instances only, 0 for chunk meshes) and block type
+layout (location = 3) in uint aBlock;
 
 out vec2 texCoord;
 out vec3 colorData;
+flat out int textureLayer;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -12,7 +15,9 @@ uniform mat4 projection;
 
 void main() 
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    vec3 offset = vec3(aBlock & 15u, (aBlock >> 8) & 127u, (aBlock >> 4) & 15u);
+    gl_Position = projection * view * model * vec4(aPos + offset, 1.0f);
     colorData = aColor;
     texCoord = aTexCoord;
+    textureLayer = int(aBlock >> 16);
 }
\ No newline at end of file
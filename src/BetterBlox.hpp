@@ -11,26 +11,44 @@
 #include "glm/gtc/type_ptr.hpp"
 
 // STL
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <random>
 #include <stack>
 #include <string>
 #include <unordered_set>
+#include <vector>
 #include <chrono>
 
 // Header Files
 #include "Block.hpp"
 #include "Camera.hpp"
+#include "Chunk.hpp"
 #include "ChunkLoader.hpp"
+#include "ChunkMap.hpp"
+#include "ChunkMesher.hpp"
+#include "ChunkResidency.hpp"
+#include "ChunkScheduler.hpp"
+#include "ChunkStreamer.hpp"
+#include "FrameStats.hpp"
+#include "Frustum.hpp"
 #include "Inventory.hpp"
-#include "perlin.hpp"
+#include "OcclusionCuller.hpp"
 #include "Shader.hpp"
 #include "stb_image.h"
 
 // Utilities
+#include "utils/Profiler.hpp"
 #include "utils/RuntimeError.hpp"
 
+// How chunks are drawn, chosen at startup so the two can be compared
+enum class RenderMode {
+    MESHED,   // One greedy-meshed vertex buffer per chunk
+    INSTANCED // One instance of the cube per visible block, from one instance buffer per chunk
+};
+
 class BetterBlox {
 private:
     // Constants
@@ -40,19 +58,41 @@ private:
     // Since VAO and VBO arrays need this before compile time, we have to use `static constexpr`
     // to initialize it at compile time.
     static constexpr unsigned int NUM_TRIANGLES = 1;
+    static constexpr int BLOCK_TEXTURE_SIZE = 256; // Width and height of every block texture layer
 
     Camera camera; // This can also be thought of as the player.
 
     std::unordered_set<Block> block_rendering; // Were the render blocks are stored
 
-    std::map<std::string, std::unordered_set<Block>> local_block_data;
+    ChunkMap<Chunk> local_block_data; // Loaded chunks, keyed by chunk position
+
+    // Chunk mesh or cube instances uploaded to the GPU
+    struct ChunkBuffer {
+        unsigned int vao = 0; // Only used for meshes, instances are drawn with VAO[0]
+        unsigned int vbo = 0;
+        int count = 0;        // Vertices of the mesh or cube instances
+        bool dirty = false;   // The chunk changed after the mesh was built
+        int neighbours = 0;   // Neighbouring chunks that were loaded when the mesh was built
+        int top = 0;          // Every block of the chunk is below this height
+    };
+    ChunkMap<ChunkBuffer> chunk_buffers;
+
+    // Chunks in render distance and their bounds, refilled every frame for frustum culling
+    struct ChunkDraw {
+        int chunk_x;
+        int chunk_z;
+        const ChunkBuffer *chunk_buffer;
+    };
+    std::vector<ChunkDraw> chunk_draws;
+    BoxBatch chunk_bounds;
+    std::vector<uint8_t> chunk_visible;
+    OcclusionCuller occlusion; // Hides chunks that are behind solid ground
 
     float last_x = SCR_WIDTH / 2.0f;
     float last_y = SCR_HEIGHT / 2.0f;
 
     bool first_mouse = true;
     std::unordered_set<Block> cube_positions;
-    std::stack<std::pair<int, int> > render;
 
     GLFWwindow *window; // Check BetterBlox::initialize() for initialization
 
@@ -73,7 +113,7 @@ private:
 
     // Timing
     float delta_time = 0.0f;
-    float last_frame = 0.0f;
+    std::chrono::steady_clock::time_point last_frame_start = std::chrono::steady_clock::now();
     std::chrono::system_clock::time_point last_call_time = std::chrono::system_clock::from_time_t(0);
 
 
@@ -85,14 +125,40 @@ private:
     Shader *block_shader = nullptr;
     Shader *inventory_shader = nullptr;
 
+    // Uniform handles, looked up once after the shaders are loaded
+    Uniform<glm::mat4> block_model, block_view, block_projection;
+    Uniform<glm::mat4> dot_model;
+    Uniform<glm::mat4> inventory_model, inventory_view, inventory_projection;
+    Uniform<int> inventory_texture, inventory_combine;
+
     // MultiThreading
-    // std::thread chunk_thread;
-    // std::thread read_thread;
+    ChunkStreamer streamer; // Generates, loads and saves chunks on worker threads
+    ChunkScheduler scheduler; // Decides which chunks the streamer works on next
+    ChunkResidency residency; // Decides which loaded chunks stay in memory
 
     // Settings
+    RenderMode render_mode;
     int render_distance = 3;
     int buffer = 1;
+    double chunk_budget_ms = 2.0; // Time per frame that may be spent adding streamed chunks to the world
+    double mesh_budget_ms = 2.0;  // Time per frame that may be spent building chunk meshes
     bool show_inventory_menu = false;
+    bool trace_key_held = false; // F3 was down last frame, so holding it only writes one trace
+    static constexpr const char *TRACE_FILE = "trace.json";
+
+    // Statistics of the last frame
+    size_t chunks_drawn = 0;
+    size_t chunks_culled = 0;   // Chunks in render distance that were outside the view frustum
+    size_t chunks_occluded = 0; // Chunks in render distance that the camera cannot see through air
+
+    // Percentiles of the last few seconds of frames, F4 prints them and every window is appended to the log
+    static constexpr const char *FRAME_STATS_LOG = "frame_stats.log";
+    FrameStats frame_stats{FRAME_STATS_LOG};
+    uint64_t last_bytes_read = 0;
+    uint64_t last_bytes_written = 0;
+    uint64_t last_cancelled = 0;
+    uint64_t last_evicted = 0;
+    bool stats_key_held = false; // F4 was down last frame
 
     // Function Prototypes
     /**
@@ -106,6 +172,33 @@ private:
      */
     void updateFrame();
 
+    /**
+     * Builds meshes for chunks in render distance that were loaded or changed, and frees the meshes of chunks that
+     * were unloaded. Meshes are built until mesh_budget_ms runs out, but at least one is built every frame.
+     */
+    void updateMeshes();
+
+    /**
+     * Copies a chunk mesh into its vertex buffer, creating the buffer the first time.
+     * @param chunk_buffer GPU side of the chunk mesh
+     * @param mesh Mesh built by ChunkMesher
+     */
+    void uploadMesh(ChunkBuffer &chunk_buffer, const ChunkMesh &mesh);
+
+    /**
+     * Copies the cube instances of a chunk into its instance buffer, creating the buffer the first time.
+     * @param chunk_buffer GPU side of the chunk instances
+     * @param instances Instances built by ChunkMesher
+     */
+    void uploadInstances(ChunkBuffer &chunk_buffer, const ChunkInstances &instances);
+
+    /**
+     * Marks the meshes that show a block as out of date. A block on the border of a chunk can hide a face of the
+     * neighbouring chunk so its mesh is marked too.
+     * @param position World position of the block that changed
+     */
+    void markMeshesDirty(glm::vec3 position);
+
     // These functions need to be static to be able to pass them to GLFW.
     static void frameBufferSizeCallback(GLFWwindow *window, int width, int height);
     static void errorCallback(int error, const char *msg);
@@ -118,7 +211,7 @@ private:
      * @param y_offset
      * @param chunk_rendering
      */
-    void processInput(GLFWwindow *window, int &combine, float &x_offset, float &y_offset, std::map<std::string, std::unordered_set<Block> >& chunk_rendering, std::chrono::system_clock::time_point&);
+    void processInput(GLFWwindow *window, int &combine, float &x_offset, float &y_offset, ChunkMap<Chunk>& chunk_rendering, std::chrono::system_clock::time_point&);
 
     // Static wrapper functions are needed to pass these member functions to GLFW since they access other members.
     /**
@@ -151,15 +244,25 @@ private:
                                  float bot_a);
 
     /**
-     * This is used to make texture loading easier. It takes a bunch of lines and breaks them down into several parameters.
-     * @param texture The id of the texture that the image is being imported for.
-     * @param path The path to the image file
-     * @param type How the image pixels will be used. Linear will take the actual pixel value and gradient will take the average of the pixels
-     * @param rgb_type RGB or RGBA
+     * Loads images into the layers of one texture array, so every block texture is reached through one sampler.
+     * Images are converted to RGBA and scaled to BLOCK_TEXTURE_SIZE since every layer has the same size.
+     * @param texture The id of the texture array
+     * @param paths The path to the image file of every layer, in layer order
      */
-    void loadTexture(unsigned int &texture, std::string path, unsigned int type, unsigned int rgb_type);
+    void loadTextureArray(unsigned int &texture, const std::vector<std::string> &paths);
+
+    /**
+     * Scales an RGBA image to a square by averaging the pixels that fall in each new pixel.
+     * @param data Pixels of the image
+     * @param width Width of the image
+     * @param height Height of the image
+     * @param size Width and height of the scaled image
+     * @param scaled Pixels of the scaled image
+     */
+    static void scaleImage(const unsigned char *data, int width, int height, int size, std::vector<unsigned char> &scaled);
 
 public:
+    explicit BetterBlox(RenderMode render_mode = RenderMode::MESHED) : render_mode(render_mode) {}
     ~BetterBlox();
     void run();
 };
@@ -173,6 +276,7 @@ BetterBlox::~BetterBlox() {
 }
 
 void BetterBlox::run() {
+    PROFILE_THREAD("main");
     initialize();
     while(!glfwWindowShouldClose(window)) {
         updateFrame();
@@ -188,6 +292,10 @@ void BetterBlox::initialize() {
     camera = Camera(glm::vec3(0.0f, 11.0f, 3.0f));
     inventory = Inventory(10);
 
+    // Worlds saved before region files existed are moved over before any chunk is loaded.
+    ChunkLoader::migrateChunkFiles(".");
+    ChunkLoader::loadSeed(".");
+
     // Opengl treats the 0,0 locations on images to be the bottom. This flips the images so the 0, 0 will be at the top.
     stbi_set_flip_vertically_on_load(true);
 
@@ -358,32 +466,28 @@ void BetterBlox::initialize() {
     // texture coord
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
-
-
-    // TODO: Texture loading should be reworked, we shouldn't need 3 lines of code for each texture
-    unsigned int container_texture, diamond_ore_texture, awesome_face_texture, bedrock_texture, grass_texture, water_texture;
-
-    // Texture loading
-    loadTexture(container_texture, "assets/textures/container.jpg", GL_LINEAR, GL_RGB);
-    loadTexture(diamond_ore_texture, "assets/textures/diamonds.png", GL_LINEAR, GL_RGBA);
-    loadTexture(awesome_face_texture, "assets/textures/awesomeface.png", GL_LINEAR, GL_RGBA);
-    loadTexture(bedrock_texture, "assets/textures/bedrock.png", GL_LINEAR, GL_RGB);
-    loadTexture(grass_texture, "assets/textures/grass.jpg", GL_LINEAR, GL_RGB);
-    loadTexture(water_texture, "assets/textures/water.png", GL_LINEAR, GL_RGBA);
+    // block instance, the buffer is bound per chunk when drawing instanced
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(3);
+
+
+    // Texture loading, the layer of each block texture is its block type
+    std::vector<std::string> block_texture_paths(BLOCK_TYPES);
+    block_texture_paths[DIAMOND_ORE] = "assets/textures/diamonds.png";
+    block_texture_paths[CONTAINER] = "assets/textures/container.jpg";
+    block_texture_paths[HAPPY_FACE] = "assets/textures/awesomeface.png";
+    block_texture_paths[BEDROCK] = "assets/textures/bedrock.png";
+    block_texture_paths[GRASS] = "assets/textures/grass.jpg";
+    block_texture_paths[WATER] = "assets/textures/water.png";
+    block_texture_paths[STONE] = "assets/textures/stone.png";
+    block_texture_paths[DIRT] = "assets/textures/dirt.png";
+    block_texture_paths[SAND] = "assets/textures/sand.png";
+    unsigned int block_textures;
+    loadTextureArray(block_textures, block_texture_paths);
 
     // Texture binding
-    glActiveTexture(GL_TEXTURE0 + CONTAINER);
-    glBindTexture(GL_TEXTURE_2D, container_texture);
-    glActiveTexture(GL_TEXTURE0 + DIAMOND_ORE);
-    glBindTexture(GL_TEXTURE_2D, diamond_ore_texture);
-    glActiveTexture(GL_TEXTURE0 + HAPPY_FACE);
-    glBindTexture(GL_TEXTURE_2D, awesome_face_texture);
-    glActiveTexture(GL_TEXTURE0 + BEDROCK);
-    glBindTexture(GL_TEXTURE_2D, bedrock_texture);
-    glActiveTexture(GL_TEXTURE0 + GRASS);
-    glBindTexture(GL_TEXTURE_2D, grass_texture);
-    glActiveTexture(GL_TEXTURE0 + WATER);
-    glBindTexture(GL_TEXTURE_2D, water_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, block_textures);
 
     // Shader loading
     shader = new Shader("assets/shaders/vertexShader1.glsl", "assets/shaders/fragmentShader1.glsl");
@@ -391,37 +495,47 @@ void BetterBlox::initialize() {
     block_shader = new Shader("assets/shaders/vertexShader1.glsl", "assets/shaders/blockShader.glsl");
     inventory_shader = new Shader("assets/shaders/vertForInventoryMenu.glsl", "assets/shaders/fragForInventoryMenu.glsl");
 
+    block_model = block_shader->uniform<glm::mat4>("model");
+    block_view = block_shader->uniform<glm::mat4>("view");
+    block_projection = block_shader->uniform<glm::mat4>("projection");
+    dot_model = dot_shader->uniform<glm::mat4>("model");
+    inventory_model = inventory_shader->uniform<glm::mat4>("model");
+    inventory_view = inventory_shader->uniform<glm::mat4>("view");
+    inventory_projection = inventory_shader->uniform<glm::mat4>("projection");
+    inventory_texture = inventory_shader->uniform<int>("texturein");
+    inventory_combine = inventory_shader->uniform<int>("combine");
+
+    // Both shaders read the block textures from texture unit 0
+    block_shader->use();
+    block_shader->setInt("blockTextures", 0);
+    inventory_shader->use();
+    inventory_shader->setInt("blockTextures", 0);
+
     combine = 0;
     x_offset = 0;
     y_offset = 0;
 }
 
 void BetterBlox::updateFrame() {
-    // Finds the chunks that need to be written
-    std::stack<std::pair<int,int>> chunk_buffer;
-    int relative_x, relative_z;
-    if(camera.getPosition().x < 0) relative_x = ((camera.getPosition().x - 16)/16);
-    else relative_x = (camera.getPosition().x/16);
-    if(camera.getPosition().z < 0) relative_z = ((camera.getPosition().z - 16)/16);
-    else relative_z = (camera.getPosition().z/16);
-    for(int i = -render_distance - buffer; i <= render_distance + buffer; i++){
-        for(int j = -render_distance - buffer; j <= render_distance + buffer; j++){
-            if(!ChunkLoader::checkFile(ChunkLoader::findFile(relative_x + i, relative_z + j, true))) {
-                chunk_buffer.emplace(relative_x + i, relative_z + j);
-                std::cerr << "writing file: Chunk(" << relative_x + i  << ',' << relative_z + j << ").txt" << std::endl;
-            }
-        }
-    }
-    // Writes the chunks one frame at a time
-    if (!chunk_buffer.empty()) {
-        if (!ChunkLoader::checkFile(ChunkLoader::findFile(chunk_buffer.top().first, chunk_buffer.top().second, true)))
-            ChunkLoader::updateChunk(chunk_buffer.top().first, chunk_buffer.top().second);
-        chunk_buffer.pop();
+    PROFILE_SCOPE("updateFrame");
+    auto frame_start = std::chrono::steady_clock::now();
+    size_t draw_calls = 0, triangles = 0;
+    {
+        PROFILE_SCOPE("stream chunks");
+        FrameStats::Timer timer(frame_stats, FrameStats::STREAM_TIME);
+        // Queues the chunks that need to be loaded, or generated ahead of time in the buffer around them, nearest first
+        scheduler.update(camera.getPosition(), camera.getFront(), render_distance, buffer, local_block_data, streamer);
+        scheduler.dispatch(streamer, 2 * streamer.threadCount());
+        // Adds the chunks the workers have finished without going over the frame budget
+        streamer.integrate(local_block_data, chunk_budget_ms);
+        // Unloads chunks the player has left behind once the world no longer fits in the memory budget
+        residency.update(camera.getPosition(), render_distance, local_block_data, streamer);
     }
 
-    float current_frame = static_cast<float>(glfwGetTime());
-    delta_time = current_frame - last_frame;
-    last_frame = current_frame;
+    // Measured on the steady clock, a float of seconds since the start loses sub-millisecond detail within hours
+    frame_stats.record(FrameStats::FRAME_TIME, frame_start - last_frame_start);
+    delta_time = std::chrono::duration<float>(frame_start - last_frame_start).count();
+    last_frame_start = frame_start;
 
     // rendering commands here
     glClearColor(0.2f, 0.8f, 0.8f, 1.0f);
@@ -446,47 +560,66 @@ void BetterBlox::updateFrame() {
     // Set transformations
     projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 
-    // retrieve the matrix uniform locations
-    unsigned int view_loc = glGetUniformLocation(block_shader->getId(), "view");
-    unsigned int projection_loc = glGetUniformLocation(block_shader->getId(), "projection");
-    glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
+    block_shader->set(block_view, view);
     // note: Projection matrix rarely changes so it should be set outside of the loop.
-    glUniformMatrix4fv(projection_loc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    glBindVertexArray(VAO[0]);
-    unsigned int model_loc;
-    block_shader->use();
-
-    model = glm::mat4(1.0f);
-    model_loc = glGetUniformLocation(block_shader->getId(), "model");
-    glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model));
-
-    // Finds the chunks that need to be rendered
-    for(int i = -render_distance; i <= render_distance; i++){
-        for(int j = -render_distance; j <= render_distance; j++) {
-            if(local_block_data.find(ChunkLoader::findFile(relative_x + i, relative_z + j, true)) == local_block_data.end())
-                render.push(std::make_pair(relative_x + i, relative_z + j));
-        }
-    }
-
-    std::unordered_set<Block> temp;
-    std::string file = ChunkLoader::findFile(render.top().first, render.top().second, true);
-    ChunkLoader::readFile(file, temp);
-    if(local_block_data.find(file) == local_block_data.end() && !temp.empty()) {
-        local_block_data.insert(std::make_pair(file, *&temp));
-        render.pop();
+    block_shader->set(block_projection, projection);
+
+    // rendering of blocks, one vertex buffer per chunk. Chunks that are only kept as a cache past the render
+    // distance are skipped.
+    updateMeshes();
+    {
+        PROFILE_SCOPE("cull chunks");
+        FrameStats::Timer timer(frame_stats, FrameStats::CULL_TIME);
+        int center_x = ChunkLoader::chunkCoord((int)std::floor(camera.getPosition().x));
+        int center_z = ChunkLoader::chunkCoord((int)std::floor(camera.getPosition().z));
+        // Chunks the camera cannot see through air are not drawn
+        occlusion.search(camera.getPosition(), render_distance);
+        chunks_occluded = 0;
+        chunk_draws.clear();
+        chunk_bounds.clear();
+        chunk_buffers.forEach([&](int chunk_x, int chunk_z, const ChunkBuffer &chunk_buffer) {
+            if (std::abs(chunk_x - center_x) > render_distance || std::abs(chunk_z - center_z) > render_distance)
+                return;
+            if (chunk_buffer.count == 0)
+                return;
+            if (!occlusion.isVisible(chunk_x, chunk_z)) {
+                chunks_occluded++;
+                return;
+            }
+            // Blocks are centred on their position, so the chunk starts half a block before its corner
+            glm::vec3 corner(chunk_x * Chunk::SIZE - 0.5f, -0.5f, chunk_z * Chunk::SIZE - 0.5f);
+            chunk_draws.push_back({chunk_x, chunk_z, &chunk_buffer});
+            chunk_bounds.add(corner, corner + glm::vec3(Chunk::SIZE, chunk_buffer.top, Chunk::SIZE));
+        });
+
+        // Chunks behind the camera or outside the field of view are not drawn
+        Frustum frustum(projection * view);
+        chunks_drawn = frustum.cull(chunk_bounds, chunk_visible);
+        chunks_culled = chunk_draws.size() - chunks_drawn;
     }
-    temp.clear();
-
-    // rendering of blocks
-    for(auto itk : local_block_data){
-        for(auto itj : itk.second) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, itj.getPosition());
-            model_loc = glGetUniformLocation(block_shader->getId(), "model");
-            block_shader->setInt("texture2", ((Block)itj).getBlockType());
-            glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+    {
+        PROFILE_SCOPE("draw chunks");
+        FrameStats::Timer timer(frame_stats, FrameStats::DRAW_TIME);
+        if (render_mode == RenderMode::INSTANCED)
+            glBindVertexArray(VAO[0]);
+        for (size_t i = 0; i < chunk_draws.size(); i++) {
+            if (!chunk_visible[i])
+                continue;
+            const ChunkDraw &draw = chunk_draws[i];
+            model = glm::translate(glm::mat4(1.0f), glm::vec3(draw.chunk_x * Chunk::SIZE, 0, draw.chunk_z * Chunk::SIZE));
+            block_shader->set(block_model, model);
+            if (render_mode == RenderMode::INSTANCED) {
+                glBindBuffer(GL_ARRAY_BUFFER, draw.chunk_buffer->vbo);
+                glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void *)0);
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 36, draw.chunk_buffer->count);
+                triangles += 12 * (size_t)draw.chunk_buffer->count;
+            }
+            else {
+                glBindVertexArray(draw.chunk_buffer->vao);
+                glDrawArrays(GL_TRIANGLES, 0, draw.chunk_buffer->count);
+                triangles += (size_t)draw.chunk_buffer->count / 3;
+            }
+            draw_calls++;
         }
     }
     // User input function call
@@ -498,31 +631,29 @@ void BetterBlox::updateFrame() {
 
     dot_shader->use();
     glBindVertexArray(vao_dot);
-    int m_loc = glGetUniformLocation(dot_shader->getId(), "model");
-    glUniformMatrix4fv(m_loc, 1, GL_FALSE, glm::value_ptr(model));
+    dot_shader->set(dot_model, model);
     glDrawArrays(GL_TRIANGLES, 0, 12);
+    draw_calls++, triangles += 4;
     // Draw the inventory here.
     // inventoryShader.use();
     model = glm::translate(model, glm::vec3(-1.8f, -0.8f, 0.0f));
     inventory_shader->use();
+    inventory_shader->set(inventory_projection, projection);
+    inventory_shader->set(inventory_view, view);
+    glBindVertexArray(inventory_vao);
     int selection = 0;
     for (int i = 0; i < inventory.size(); i++) {
-        inventory_shader->setInt("texturein", (i));
+        inventory_shader->set(inventory_texture, i);
         model = glm::translate(model, glm::vec3(0.55f, 0.0f, 0.0f));
-        glBindVertexArray(inventory_vao);
-        int projection_2d_loc = glGetUniformLocation(inventory_shader->getId(), "projection");
-        int model_2d_loc = glGetUniformLocation(inventory_shader->getId(), "model");
-        int view_2d_loc = glGetUniformLocation(inventory_shader->getId(), "view");
-        glUniformMatrix4fv(projection_2d_loc, 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(model_2d_loc, 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(view_2d_loc, 1, GL_FALSE, glm::value_ptr(camera.getViewMatrix()));
+        inventory_shader->set(inventory_model, model);
         if (combine == i) {
-            inventory_shader->setInt("combine", 1);
+            inventory_shader->set(inventory_combine, 1);
         }
         else {
-            inventory_shader->setInt("combine", 0);
+            inventory_shader->set(inventory_combine, 0);
         }
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        draw_calls++, triangles += 2;
     }
 
     // draw inventory menu
@@ -531,10 +662,124 @@ void BetterBlox::updateFrame() {
     }
 
 
+    frame_stats.record(FrameStats::CPU_TIME, std::chrono::steady_clock::now() - frame_start);
+    frame_stats.record(FrameStats::DRAW_CALLS, draw_calls);
+    frame_stats.record(FrameStats::TRIANGLES, triangles);
+    frame_stats.record(FrameStats::CHUNKS_DRAWN, chunks_drawn);
+    frame_stats.record(FrameStats::CHUNKS_CULLED, chunks_culled);
+    frame_stats.record(FrameStats::CHUNKS_OCCLUDED, chunks_occluded);
+    frame_stats.record(FrameStats::RESIDENT_CHUNKS, residency.residentChunks());
+    frame_stats.record(FrameStats::RESIDENT_BYTES, residency.residentBytes());
+    frame_stats.record(FrameStats::CHUNKS_EVICTED, residency.getEvicted() - last_evicted);
+    last_evicted = residency.getEvicted();
+    uint64_t bytes_read = ChunkLoader::stats().bytes_read, bytes_written = ChunkLoader::stats().bytes_written;
+    frame_stats.record(FrameStats::BYTES_READ, bytes_read - last_bytes_read);
+    frame_stats.record(FrameStats::BYTES_WRITTEN, bytes_written - last_bytes_written);
+    last_bytes_read = bytes_read;
+    last_bytes_written = bytes_written;
+    frame_stats.record(FrameStats::QUEUE_DEPTH, scheduler.queueDepth(streamer));
+    frame_stats.record(FrameStats::CHUNKS_CANCELLED, scheduler.getCancelled() - last_cancelled);
+    last_cancelled = scheduler.getCancelled();
+
     // check and call events and swap the buffers
-    glfwSwapBuffers(window);
+    {
+        PROFILE_SCOPE("glfwSwapBuffers");
+        FrameStats::Timer timer(frame_stats, FrameStats::SWAP_TIME);
+        glfwSwapBuffers(window);
+    }
     glfwPollEvents();
+    frame_stats.endFrame();
+
+}
+
+void BetterBlox::updateMeshes() {
+    PROFILE_SCOPE("updateMeshes");
+    FrameStats::Timer timer(frame_stats, FrameStats::MESH_TIME);
+    // Meshes of unloaded chunks
+    std::vector<std::pair<int, int>> unloaded;
+    chunk_buffers.forEach([&](int chunk_x, int chunk_z, ChunkBuffer &chunk_buffer) {
+        if (local_block_data.contains(chunk_x, chunk_z))
+            return;
+        glDeleteVertexArrays(1, &chunk_buffer.vao);
+        glDeleteBuffers(1, &chunk_buffer.vbo);
+        occlusion.remove(chunk_x, chunk_z);
+        unloaded.emplace_back(chunk_x, chunk_z);
+    });
+    for (const auto &[chunk_x, chunk_z] : unloaded)
+        chunk_buffers.erase(chunk_x, chunk_z);
+
+    int center_x = ChunkLoader::chunkCoord((int)std::floor(camera.getPosition().x));
+    int center_z = ChunkLoader::chunkCoord((int)std::floor(camera.getPosition().z));
+    auto start = std::chrono::steady_clock::now();
+    bool out_of_time = false;
+    local_block_data.forEach([&](int chunk_x, int chunk_z, const Chunk &chunk) {
+        if (out_of_time || std::abs(chunk_x - center_x) > render_distance || std::abs(chunk_z - center_z) > render_distance)
+            return;
+        ChunkNeighbours neighbours{local_block_data.find(chunk_x - 1, chunk_z), local_block_data.find(chunk_x + 1, chunk_z),
+                                   local_block_data.find(chunk_x, chunk_z - 1), local_block_data.find(chunk_x, chunk_z + 1)};
+        ChunkBuffer *chunk_buffer = chunk_buffers.find(chunk_x, chunk_z);
+        // Meshes are rebuilt when a neighbour arrives or leaves, since that changes which border faces are hidden
+        if (chunk_buffer != nullptr && !chunk_buffer->dirty && chunk_buffer->neighbours == neighbours.loaded())
+            return;
+        if (chunk_buffer == nullptr)
+            chunk_buffer = &chunk_buffers.insert(chunk_x, chunk_z, ChunkBuffer{});
+        if (render_mode == RenderMode::INSTANCED)
+            uploadInstances(*chunk_buffer, ChunkMesher::buildInstances(chunk, neighbours));
+        else
+            uploadMesh(*chunk_buffer, ChunkMesher::build(chunk, neighbours));
+        chunk_buffer->neighbours = neighbours.loaded();
+        chunk_buffer->top = chunk.getTop();
+        occlusion.update(chunk);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        out_of_time = elapsed.count() >= mesh_budget_ms;
+    });
+}
+
+void BetterBlox::uploadMesh(ChunkBuffer &chunk_buffer, const ChunkMesh &mesh) {
+    if (chunk_buffer.vao == 0) {
+        glGenVertexArrays(1, &chunk_buffer.vao);
+        glGenBuffers(1, &chunk_buffer.vbo);
+        glBindVertexArray(chunk_buffer.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, chunk_buffer.vbo);
+        // Same layout as the cube plus the packed block, so the block shader works for both
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void *)offsetof(MeshVertex, x));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void *)offsetof(MeshVertex, r));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void *)offsetof(MeshVertex, u));
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(MeshVertex), (void *)offsetof(MeshVertex, block));
+        glEnableVertexAttribArray(3);
+    }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, chunk_buffer.vbo);
+    }
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(MeshVertex), mesh.vertices.data(), GL_STATIC_DRAW);
+    chunk_buffer.count = (int)mesh.vertices.size();
+    chunk_buffer.dirty = false;
+}
 
+void BetterBlox::uploadInstances(ChunkBuffer &chunk_buffer, const ChunkInstances &instances) {
+    if (chunk_buffer.vbo == 0)
+        glGenBuffers(1, &chunk_buffer.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk_buffer.vbo);
+    glBufferData(GL_ARRAY_BUFFER, instances.instances.size() * sizeof(uint32_t), instances.instances.data(), GL_STATIC_DRAW);
+    chunk_buffer.count = (int)instances.instances.size();
+    chunk_buffer.dirty = false;
+}
+
+void BetterBlox::markMeshesDirty(glm::vec3 position) {
+    int x = (int)position.x, z = (int)position.z;
+    int chunk_x = ChunkLoader::chunkCoord(x), chunk_z = ChunkLoader::chunkCoord(z);
+    auto mark = [&](int mark_x, int mark_z) {
+        if (ChunkBuffer *chunk_buffer = chunk_buffers.find(mark_x, mark_z))
+            chunk_buffer->dirty = true;
+    };
+    mark(chunk_x, chunk_z);
+    if (Chunk::toLocal(x) == 0) mark(chunk_x - 1, chunk_z);
+    if (Chunk::toLocal(x) == Chunk::SIZE - 1) mark(chunk_x + 1, chunk_z);
+    if (Chunk::toLocal(z) == 0) mark(chunk_x, chunk_z - 1);
+    if (Chunk::toLocal(z) == Chunk::SIZE - 1) mark(chunk_x, chunk_z + 1);
 }
 
 void BetterBlox::frameBufferSizeCallback(GLFWwindow *window, int width, int height) {
@@ -556,13 +801,30 @@ void BetterBlox::errorCallback(int error, const char *msg) {
  * @param chunk_rendering Local Cache
  * @param last_call_time Cooldown since last called
  */
-void BetterBlox::processInput(GLFWwindow *window, int &combine, float &x_offset, float &y_offset, std::map<std::string, std::unordered_set<Block> >& chunk_rendering, std::chrono::system_clock::time_point& last_call_time) {
+void BetterBlox::processInput(GLFWwindow *window, int &combine, float &x_offset, float &y_offset, ChunkMap<Chunk>& chunk_rendering, std::chrono::system_clock::time_point& last_call_time) {
+    PROFILE_SCOPE("processInput");
+    FrameStats::Timer timer(frame_stats, FrameStats::INPUT_TIME);
     // initializing variables for cooldown
     std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = now - last_call_time;
 
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+#ifdef BETTERBLOX_PROFILE
+    // Writes out the recorded scopes once per press
+    bool trace_key = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+    if (trace_key && !trace_key_held) {
+        if (Profiler::writeChromeTrace(TRACE_FILE))
+            std::cout << "Wrote " << TRACE_FILE << ", open it in chrome://tracing or ui.perfetto.dev" << std::endl;
+        else
+            std::cerr << "Cannot Write File: " << TRACE_FILE << std::endl;
+    }
+    trace_key_held = trace_key;
+#endif
+    bool stats_key = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+    if (stats_key && !stats_key_held)
+        std::cout << frame_stats.report();
+    stats_key_held = stats_key;
     if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
         show_inventory_menu ? show_inventory_menu = false : show_inventory_menu = true;
     if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
@@ -577,8 +839,12 @@ void BetterBlox::processInput(GLFWwindow *window, int &combine, float &x_offset,
         combine = GRASS;
     if (glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS)
         combine = WATER;
+    if (glfwGetKey(window, GLFW_KEY_7) == GLFW_PRESS)
+        combine = STONE;
+    if (glfwGetKey(window, GLFW_KEY_8) == GLFW_PRESS)
+        combine = DIRT;
     if (glfwGetKey(window, GLFW_KEY_9) == GLFW_PRESS)
-        combine = 9;
+        combine = SAND;
     if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
         x_offset += 0.01;
     if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
@@ -609,25 +875,33 @@ void BetterBlox::processInput(GLFWwindow *window, int &combine, float &x_offset,
             camera_position.x = (float)std::round(camera_position.x);
             camera_position.y = (float)std::round(camera_position.y);
             camera_position.z = (float)std::round(camera_position.z);
-            for (int i = 0; i < 10; i++) {   // Check for a valid block id
-                glm::vec3 cursor = camera.getPosition() + (camera.getFront() * (distance - 1));
-                cursor.x = (float)std::round(cursor.x);
-                cursor.y = (float)std::round(cursor.y);
-                cursor.z = (float)std::round(cursor.z);
-                std::string chunk = ChunkLoader::findFile(camera_position.x, camera_position.z, false);
-                if (chunk_rendering.find(chunk)->second.find(Block(camera_position,i)) != chunk_rendering.find(chunk)->second.end()) {
-                    if (glfwGetMouseButton(window, 0 == GLFW_PRESS)) {
-                        ChunkLoader::placeCube(cursor, combine);
-                        chunk_rendering.find(chunk)->second.insert(Block(cursor,combine));
+            glm::vec3 cursor = camera.getPosition() + (camera.getFront() * (distance - 1));
+            cursor.x = (float)std::round(cursor.x);
+            cursor.y = (float)std::round(cursor.y);
+            cursor.z = (float)std::round(cursor.z);
+            Chunk *chunk = chunk_rendering.find(ChunkLoader::chunkCoord(camera_position.x), ChunkLoader::chunkCoord(camera_position.z));
+            if (chunk == nullptr)
+                continue;
+            int block_id = chunk->get(Chunk::toLocal(camera_position.x), camera_position.y, Chunk::toLocal(camera_position.z));
+            if (block_id != AIR) {
+                if (glfwGetMouseButton(window, 0 == GLFW_PRESS)) {
+                    streamer.requestWrite([cursor, block_type = combine] { ChunkLoader::placeCube(cursor, block_type); });
+                    Chunk *cursor_chunk = chunk_rendering.find(ChunkLoader::chunkCoord(cursor.x), ChunkLoader::chunkCoord(cursor.z));
+                    if (cursor_chunk != nullptr) {
+                        cursor_chunk->set(Chunk::toLocal(cursor.x), cursor.y, Chunk::toLocal(cursor.z), combine);
+                        residency.markDirty(cursor_chunk->getX(), cursor_chunk->getZ());
+                        markMeshesDirty(cursor);
                     }
+                }
 
-                    else if (glfwGetMouseButton(window, 1 == GLFW_PRESS)) {
-                        ChunkLoader::deleteBlock(camera_position, i, ChunkLoader::findFile(camera_position.x, camera_position.z, false));
-                        chunk_rendering.find(chunk)->second.erase(Block(camera_position, i));
-                    }
-                    last_call_time = now;
-                    return;
+                else if (glfwGetMouseButton(window, 1 == GLFW_PRESS)) {
+                    streamer.requestWrite([camera_position, block_id] { ChunkLoader::deleteBlock(camera_position, block_id); });
+                    chunk->set(Chunk::toLocal(camera_position.x), camera_position.y, Chunk::toLocal(camera_position.z), AIR);
+                    residency.markDirty(chunk->getX(), chunk->getZ());
+                    markMeshesDirty(camera_position);
                 }
+                last_call_time = now;
+                return;
             }
         }
     }
@@ -708,6 +982,8 @@ void BetterBlox::myglGradientBackground(float top_r, float top_g, float top_b, f
 
     static GLuint background_vao = 0;
     static GLuint background_shader = 0;
+    static GLint top_color_loc = -1;
+    static GLint bot_color_loc = -1;
 
     if (background_vao == 0) {
         glGenVertexArrays(1, &background_vao);
@@ -749,11 +1025,11 @@ void BetterBlox::myglGradientBackground(float top_r, float top_g, float top_b, f
         glDeleteShader(fs_id);
         glDeleteShader(vs_id);
         glUseProgram(background_shader);
+        top_color_loc = glGetUniformLocation(background_shader, "top_color");
+        bot_color_loc = glGetUniformLocation(background_shader, "bot_color");
     }
 
     glUseProgram(background_shader);
-    GLuint top_color_loc = glGetUniformLocation(background_shader, "top_color");
-    GLuint bot_color_loc = glGetUniformLocation(background_shader, "bot_color");
     glUniform4f(top_color_loc, top_r, top_g, top_b, top_a);
     glUniform4f(bot_color_loc, bot_r, bot_g, bot_b, bot_a);
 
@@ -764,27 +1040,51 @@ void BetterBlox::myglGradientBackground(float top_r, float top_g, float top_b, f
     glEnable(GL_DEPTH_TEST);
 }
 
-void BetterBlox::loadTexture(unsigned int &texture, std::string path, unsigned int type, unsigned int rgb_type) {
+void BetterBlox::loadTextureArray(unsigned int &texture, const std::vector<std::string> &paths) {
     glGenTextures(1, &texture);
-    int width, height, nr_channels;
-    unsigned char *data = stbi_load(path.c_str(), &width, &height, &nr_channels, 0);
-    if (!data) {
-        std::cout << "Failed to load data" << std::endl;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURE_SIZE, (int)paths.size(), 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+
+    std::vector<unsigned char> layer;
+    for (int i = 0; i < (int)paths.size(); i++) {
+        int width, height, nr_channels;
+        unsigned char *data = stbi_load(paths[i].c_str(), &width, &height, &nr_channels, 4);
+        if (!data) {
+            std::cout << "Failed to load data" << std::endl;
+            continue;
+        }
+        scaleImage(data, width, height, BLOCK_TEXTURE_SIZE, layer);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURE_SIZE, 1, GL_RGBA,
+                        GL_UNSIGNED_BYTE, layer.data());
+        stbi_image_free(data);
     }
 
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, type);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, type);
-
-    float border_color[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_color);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, rgb_type, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Merged chunk faces repeat the texture once per block, and mipmaps keep far away faces from shimmering
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
 
-    stbi_image_free(data);
+void BetterBlox::scaleImage(const unsigned char *data, int width, int height, int size, std::vector<unsigned char> &scaled) {
+    scaled.assign((size_t)size * size * 4, 0);
+    for (int y = 0; y < size; y++) {
+        int y0 = y * height / size;
+        int y1 = std::max(y0 + 1, (y + 1) * height / size);
+        for (int x = 0; x < size; x++) {
+            int x0 = x * width / size;
+            int x1 = std::max(x0 + 1, (x + 1) * width / size);
+            unsigned int sum[4] = {0, 0, 0, 0};
+            for (int sy = y0; sy < y1; sy++) {
+                for (int sx = x0; sx < x1; sx++) {
+                    const unsigned char *pixel = data + ((size_t)sy * width + sx) * 4;
+                    for (int c = 0; c < 4; c++) sum[c] += pixel[c];
+                }
+            }
+            unsigned int count = (unsigned int)((y1 - y0) * (x1 - x0));
+            for (int c = 0; c < 4; c++) scaled[((size_t)y * size + x) * 4 + c] = (unsigned char)(sum[c] / count);
+        }
+    }
 }
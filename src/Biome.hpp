@@ -2,19 +2,61 @@
 #ifndef BIOME_H
 #define BIOME_H
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 class Biome {
 private:
     std::unordered_map<int, int> related_blocks; // The int will take the id of the blocks that are related to the landscape of the Biome. The value is how populous the block is.
     std::string name;
+    int subsurface_block;  // Block under the surface
+    float base_height;     // Height of the ground where the terrain noise is zero
+    float height_range;    // Blocks the ground rises or sinks around the base height
+
+    // related_blocks in id order with the running total of their weights, so picking does not depend on hash order
+    std::vector<std::pair<int, int>> surface_weights;
+    int total_weight = 0;
+
 public:
-    Biome(const std::string &name, std::unordered_map<int, int> blocks = std::unordered_map<int, int>()) {
+    Biome(const std::string &name, std::unordered_map<int, int> blocks = std::unordered_map<int, int>(),
+          int subsurface_block = 0, float base_height = 0, float height_range = 0) {
         this->name = name;
         this->related_blocks = blocks;
+        this->subsurface_block = subsurface_block;
+        this->base_height = base_height;
+        this->height_range = height_range;
+
+        std::vector<std::pair<int, int>> sorted(blocks.begin(), blocks.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (const auto &[block, weight] : sorted) {
+            if (weight <= 0) continue;
+            total_weight += weight;
+            surface_weights.emplace_back(block, total_weight);
+        }
+    }
+
+    const std::string &getName() const { return name; }
+    int getSubsurfaceBlock() const { return subsurface_block; }
+    float getBaseHeight() const { return base_height; }
+    float getHeightRange() const { return height_range; }
+
+    /**
+     * @brief Picks a surface block from the related blocks, more populous blocks are picked more often
+     * @param roll Random number for the column, the same roll always picks the same block
+     * @return Block id, or the subsurface block if the biome has no related blocks
+     */
+    int pickSurfaceBlock(uint32_t roll) const {
+        if (total_weight == 0) return subsurface_block;
+        int target = (int)(roll % (uint32_t)total_weight);
+        for (const auto &[block, running] : surface_weights) {
+            if (target < running) return block;
+        }
+        return surface_weights.back().first;
     }
 };
 
-#endif BIOME_H
\ No newline at end of file
+#endif
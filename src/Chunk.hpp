@@ -0,0 +1,293 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+// STL
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block id of empty space. Real block ids come from the enum in Inventory.hpp.
+constexpr int AIR = -1;
+
+/**
+ * @brief Dense 16x16x16 cube of blocks
+ * Every block is stored as a bit-packed index into a small palette of the block ids used in the section, so a
+ * section with a handful of block types takes a few bits per block. Index 0 of the palette is always AIR, which
+ * means a new section is empty without storing anything. get() and set() are O(1) and blocks are stored in
+ * x, then z, then y order so neighbouring blocks are close together in memory.
+ */
+class ChunkSection {
+public:
+    constexpr static int SIZE = 16;
+    constexpr static int VOLUME = SIZE * SIZE * SIZE;
+
+private:
+    std::vector<int> palette{AIR};
+    std::vector<uint64_t> data; // Packed palette indices, entries never straddle two words
+    int bits = 0;               // Bits per palette index, 0 while the section is only air
+    int block_count = 0;        // Blocks that are not air
+
+    static int index(int x, int y, int z) { return (y * SIZE + z) * SIZE + x; }
+    int perWord() const { return 64 / bits; }
+
+    int getIndex(int i) const {
+        if (bits == 0) return 0;
+        uint64_t word = data[i / perWord()];
+        return (int)((word >> ((i % perWord()) * bits)) & ((uint64_t(1) << bits) - 1));
+    }
+
+    void setIndex(int i, int palette_index) {
+        uint64_t &word = data[i / perWord()];
+        int shift = (i % perWord()) * bits;
+        uint64_t mask = ((uint64_t(1) << bits) - 1) << shift;
+        word = (word & ~mask) | ((uint64_t)palette_index << shift);
+    }
+
+    /**
+     * @brief Repacks every index with a new number of bits
+     * @param new_bits Bits per palette index
+     */
+    void resize(int new_bits) {
+        std::vector<int> indices(VOLUME);
+        for (int i = 0; i < VOLUME; i++) indices[i] = getIndex(i);
+        bits = new_bits;
+        data.assign((VOLUME + perWord() - 1) / perWord(), 0);
+        for (int i = 0; i < VOLUME; i++) setIndex(i, indices[i]);
+    }
+
+    /**
+     * @brief Finds a block id in the palette, adding it if it is not there yet
+     * @return Palette index of the block id
+     */
+    int paletteIndex(int block_id) {
+        for (int i = 0; i < (int)palette.size(); i++) {
+            if (palette[i] == block_id) return i;
+        }
+        palette.push_back(block_id);
+        if ((int)palette.size() > (1 << bits)) {
+            int new_bits = bits;
+            while ((int)palette.size() > (1 << new_bits)) new_bits++;
+            resize(new_bits);
+        }
+        return (int)palette.size() - 1;
+    }
+
+public:
+    /**
+     * @brief Gets the block id at a position inside the section
+     * @return Block id, or AIR if there is no block
+     */
+    int get(int x, int y, int z) const {
+        return palette[getIndex(index(x, y, z))];
+    }
+
+    /**
+     * @brief Sets the block id at a position inside the section
+     * @param block_id Block id, or AIR to remove the block
+     */
+    void set(int x, int y, int z, int block_id) {
+        int i = index(x, y, z);
+        int old_index = getIndex(i);
+        if (palette[old_index] == block_id) return;
+        int new_index = paletteIndex(block_id);
+        setIndex(i, new_index);
+        block_count += (old_index == 0) - (new_index == 0);
+    }
+
+    /**
+     * @brief Replaces every block of the section at once, much faster than setting them one by one
+     * The palette is built in one pass and the indices are packed a word at a time.
+     *
+     * @param blocks VOLUME block ids in storage order, index (y * SIZE + z) * SIZE + x
+     */
+    void assign(const int *blocks) {
+        palette.assign(1, AIR);
+        block_count = 0;
+        std::array<uint8_t, VOLUME> indices; // Block ids fit in 7 bits, so the palette never has more than 129 entries
+        int last_id = AIR, last_index = 0;
+        for (int i = 0; i < VOLUME; i++) {
+            if (blocks[i] != last_id) {
+                last_id = blocks[i];
+                last_index = 0;
+                while (last_index < (int)palette.size() && palette[last_index] != last_id) last_index++;
+                if (last_index == (int)palette.size()) palette.push_back(last_id);
+            }
+            indices[i] = (uint8_t)last_index;
+            block_count += last_index != 0;
+        }
+
+        bits = 0;
+        while ((int)palette.size() > (1 << bits)) bits++;
+        data.clear();
+        if (bits == 0) return;
+        int per_word = perWord();
+        data.assign((VOLUME + per_word - 1) / per_word, 0);
+        for (int w = 0, i = 0; i < VOLUME; w++) {
+            uint64_t word = 0;
+            for (int k = 0; k < per_word && i < VOLUME; k++, i++) word |= (uint64_t)indices[i] << (k * bits);
+            data[w] = word;
+        }
+    }
+
+    /**
+     * @brief Copies every block of the section out at once, the opposite of assign()
+     * @param blocks Receives VOLUME block ids in storage order
+     */
+    void unpack(int *blocks) const {
+        if (bits == 0) {
+            std::fill(blocks, blocks + VOLUME, AIR);
+            return;
+        }
+        int per_word = perWord();
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        for (int w = 0, i = 0; i < VOLUME; w++) {
+            uint64_t word = data[w];
+            for (int k = 0; k < per_word && i < VOLUME; k++, i++, word >>= bits) blocks[i] = palette[word & mask];
+        }
+    }
+
+    bool empty() const { return block_count == 0; }
+    int getBlockCount() const { return block_count; }
+
+    /**
+     * @brief Approximate heap memory used by the section
+     */
+    size_t memoryUsage() const {
+        return sizeof(ChunkSection) + palette.capacity() * sizeof(int) + data.capacity() * sizeof(uint64_t);
+    }
+
+    /**
+     * @brief Calls a function for every block that is not air, in storage order
+     * @param fn Called as fn(x, y, z, block_id) with positions inside the section
+     */
+    template<class Function>
+    void forEachBlock(Function &&fn) const {
+        if (block_count == 0) return;
+        for (int i = 0; i < VOLUME; i++) {
+            int palette_index = getIndex(i);
+            if (palette_index == 0) continue;
+            fn(i % SIZE, i / (SIZE * SIZE), (i / SIZE) % SIZE, palette[palette_index]);
+        }
+    }
+};
+
+/**
+ * @brief Column of ChunkSections that covers one chunk from the bottom to the top of the world
+ * Positions passed to get() and set() are relative to the corner of the chunk.
+ */
+class Chunk {
+public:
+    constexpr static int SIZE = ChunkSection::SIZE;
+    constexpr static int SECTIONS = 8;
+    constexpr static int HEIGHT = SIZE * SECTIONS; // Y is stored with 7 bits in the save files
+
+private:
+    int chunk_x;
+    int chunk_z;
+    std::array<ChunkSection, SECTIONS> sections;
+
+public:
+    Chunk(int chunk_x = 0, int chunk_z = 0) : chunk_x(chunk_x), chunk_z(chunk_z) {}
+
+    int getX() const { return chunk_x; }
+    int getZ() const { return chunk_z; }
+
+    /**
+     * @brief Converts a world X or Z position into a position inside the chunk that holds it
+     */
+    static int toLocal(int world) {
+        return ((world % SIZE) + SIZE) % SIZE;
+    }
+
+    static bool contains(int x, int y, int z) {
+        return x >= 0 && x < SIZE && z >= 0 && z < SIZE && y >= 0 && y < HEIGHT;
+    }
+
+    /**
+     * @brief Gets the block id at a position inside the chunk
+     * @return Block id, or AIR if there is no block or the position is outside the chunk
+     */
+    int get(int x, int y, int z) const {
+        if (!contains(x, y, z)) return AIR;
+        return sections[y / SIZE].get(x, y % SIZE, z);
+    }
+
+    /**
+     * @brief Sets the block id at a position inside the chunk, positions outside the chunk are ignored
+     * @param block_id Block id, or AIR to remove the block
+     */
+    void set(int x, int y, int z, int block_id) {
+        if (!contains(x, y, z)) return;
+        sections[y / SIZE].set(x, y % SIZE, z, block_id);
+    }
+
+    /**
+     * @brief Replaces the blocks of the lowest sections of the chunk at once
+     * @param blocks Block ids in storage order, index (y * SIZE + z) * SIZE + x
+     * @param height Number of layers in blocks, a multiple of SIZE. Sections above it are left alone.
+     */
+    void assign(const int *blocks, int height) {
+        for (int s = 0; s < height / SIZE && s < SECTIONS; s++) sections[s].assign(blocks + s * ChunkSection::VOLUME);
+    }
+
+    /**
+     * @brief Replaces every block of one section at once, different sections can be assigned on different threads
+     * @param section Index of the section from the bottom
+     * @param blocks ChunkSection::VOLUME block ids in storage order
+     */
+    void assign(int section, const int *blocks) { sections[section].assign(blocks); }
+
+    /**
+     * @brief Copies the blocks of the lowest sections of the chunk out at once, the opposite of assign()
+     * @param blocks Receives height * SIZE * SIZE block ids in storage order
+     * @param height Number of layers to copy, a multiple of SIZE
+     */
+    void unpack(int *blocks, int height) const {
+        for (int s = 0; s < height / SIZE && s < SECTIONS; s++) sections[s].unpack(blocks + s * ChunkSection::VOLUME);
+    }
+
+    const ChunkSection &getSection(int section) const { return sections[section]; }
+
+    bool empty() const {
+        for (const ChunkSection &section : sections) {
+            if (!section.empty()) return false;
+        }
+        return true;
+    }
+
+    int getBlockCount() const {
+        int count = 0;
+        for (const ChunkSection &section : sections) count += section.getBlockCount();
+        return count;
+    }
+
+    /**
+     * @brief Height of the top of the highest section that has blocks in it, everything above is air
+     */
+    int getTop() const {
+        int top = HEIGHT;
+        while (top > 0 && sections[top / SIZE - 1].empty()) top -= SIZE;
+        return top;
+    }
+
+    size_t memoryUsage() const {
+        size_t bytes = sizeof(Chunk) - sizeof(sections);
+        for (const ChunkSection &section : sections) bytes += section.memoryUsage();
+        return bytes;
+    }
+
+    /**
+     * @brief Calls a function for every block that is not air, section by section
+     * @param fn Called as fn(x, y, z, block_id) with positions inside the chunk
+     */
+    template<class Function>
+    void forEachBlock(Function &&fn) const {
+        for (int s = 0; s < SECTIONS; s++) {
+            sections[s].forEachBlock([&](int x, int y, int z, int block_id) { fn(x, y + s * SIZE, z, block_id); });
+        }
+    }
+};
+
+#endif
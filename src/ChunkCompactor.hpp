@@ -0,0 +1,85 @@
+#ifndef CHUNKCOMPACTOR_H
+#define CHUNKCOMPACTOR_H
+
+// STL
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+// Utilities
+#include "utils/Profiler.hpp"
+
+/**
+ * @brief Background thread that rewrites chunks whose save data has built up deleted blocks
+ * Chunks are queued with request() and handed one at a time to the compact function on the worker thread. A chunk
+ * that is already queued is only compacted once. Chunks still queued when the compactor is destroyed are dropped,
+ * which is safe because the save data is valid before compaction as well.
+ */
+class ChunkCompactor {
+private:
+    std::function<void(int, int)> compact;
+    std::set<std::pair<int, int>> pending;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+    bool stopping = false;
+
+    void run();
+
+public:
+    explicit ChunkCompactor(std::function<void(int, int)> compact);
+    ~ChunkCompactor();
+
+    void request(int chunk_x, int chunk_z);
+};
+
+/**
+ * @param compact Function that compacts a single chunk, called on the worker thread
+ */
+ChunkCompactor::ChunkCompactor(std::function<void(int, int)> compact) : compact(std::move(compact)) {
+    worker = std::thread(&ChunkCompactor::run, this);
+}
+
+ChunkCompactor::~ChunkCompactor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+/**
+ * @brief Queues a chunk to be compacted
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ */
+void ChunkCompactor::request(int chunk_x, int chunk_z) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.emplace(chunk_x, chunk_z);
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Worker loop, compacts queued chunks until the compactor is destroyed
+ */
+void ChunkCompactor::run() {
+    PROFILE_THREAD("compactor");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (stopping) return;
+        std::pair<int, int> chunk = *pending.begin();
+        pending.erase(pending.begin());
+        lock.unlock();
+        compact(chunk.first, chunk.second);
+        lock.lock();
+    }
+}
+
+#endif
@@ -7,22 +7,37 @@
 #include "glm/gtc/type_ptr.hpp"
 
 // STL
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <cmath>
+#include <cstdio>
 #include <filesystem>
 #include <bitset>
 #include <cstring>
+#include <random>
 
 // Header Files
 #include "Block.hpp"
+#include "Chunk.hpp"
+#include "ChunkCompactor.hpp"
 #include "Inventory.hpp"
-#include "perlin.hpp"
+#include "RegionFile.hpp"
+#include "TerrainNoise.hpp"
+#include "WorldGenerator.hpp"
+
+// Utilities
+#include "utils/Profiler.hpp"
 
 // Bit packed struct for block information
 union BlockInfo {
@@ -38,37 +53,155 @@ union BlockInfo {
     uint64_t result;
 };
 
+// Running totals of chunk I/O, kept instead of logging every block
+struct ChunkIOStats {
+    std::atomic<uint64_t> chunks_written{0};
+    std::atomic<uint64_t> blocks_written{0};
+    std::atomic<uint64_t> bytes_written{0};
+    std::atomic<uint64_t> write_calls{0};
+    std::atomic<uint64_t> chunks_read{0};
+    std::atomic<uint64_t> bytes_read{0};
+};
+
 class ChunkLoader {
 private:
-    constexpr static int water_level = 5;
+    // ATTR flag for a record that deletes the block at its position
+    constexpr static uint64_t ATTR_TOMBSTONE = 1;
+    // ATTR bits 1-7 of a record are the number of blocks above it with the same id, so one record covers a vertical
+    // run of up to MAX_RUN blocks. Records written before runs existed have these bits clear and cover one block.
+    constexpr static int ATTR_RUN_SHIFT = 1;
+    constexpr static int MAX_RUN = 128;
+    // A chunk is compacted once this many of its records are deleted or overwritten
+    constexpr static size_t COMPACT_THRESHOLD = 32;
+
+    static WorldGenerator &generator();
+    static std::mutex &regionMutex();
+    static std::map<std::pair<int, int>, size_t> &tombstones();
+    static RegionFile &region(int chunk_x, int chunk_z);
+    static int regionCoord(int chunk);
+    static int regionLocal(int chunk);
+    static size_t replayChunk(const std::vector<char> &payload, Chunk &chunk);
+    static void encodeChunk(const Chunk &chunk, std::vector<BlockInfo> &records);
+    static void requestCompaction(int chunk_x, int chunk_z, size_t dead_records);
 
 public:
+    constexpr static int CHUNK_SIZE = 16;
+    constexpr static const char *SEED_FILE = "World.seed";
+
+    static ChunkIOStats &stats();
+    static int chunkCoord(int world);
+    static BlockInfo encodeBlock(glm::vec3 position, int block_id);
+    static Block decodeBlock(const BlockInfo &block_info);
     static void writeFile(glm::vec3 position, int block_id, int x, int z);
-    static void deleteBlock(glm::vec3 block, int block_id, const std::string& file);
-    static void readFile(std::string file, std::unordered_set<Block> &);
+    static void writeChunk(int chunk_x, int chunk_z, const std::vector<BlockInfo> &blocks);
+    static void saveChunk(const Chunk &chunk);
+    static void deleteBlock(glm::vec3 block, int block_id);
+    static void readFile(int chunk_x, int chunk_z, Chunk &chunk);
     static std::string findFile(int x, int z, bool true_file);
-    static bool checkFile(std::string path);
+    static bool checkFile(int chunk_x, int chunk_z);
+    static int migrateChunkFiles(const std::string &directory);
+    static TerrainNoise::Seed loadSeed(const std::string &directory);
+    static void setSeed(TerrainNoise::Seed seed);
+    static void compactChunk(int chunk_x, int chunk_z);
     static void placeCube(glm::vec3 position, int block_type);
-    static void updateTerrain(int start_pos_x, int start_pos_z);
+    static void generateChunk(Chunk &chunk, WorkerPool *pool = nullptr);
     static void updateChunk(int relative_x, int relative_z);
 };
 
 /**
- * @brief writes a block into a file in binary format
- * Takes values of a blocks properties and stores them into a binary format
+ * @brief Chunk I/O totals since the game started
+ */
+ChunkIOStats &ChunkLoader::stats() {
+    static ChunkIOStats io_stats;
+    return io_stats;
+}
+
+/**
+ * @brief Generator the terrain of the world comes from
+ * Only setSeed() changes it, and only before any chunk is generated, so workers can read it without a lock.
+ */
+WorldGenerator &ChunkLoader::generator() {
+    static WorldGenerator world_generator;
+    return world_generator;
+}
+
+/**
+ * @brief Lock that must be held while touching any region file
+ * Region files are shared between the game and the background compactor.
+ */
+std::mutex &ChunkLoader::regionMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/**
+ * @brief Tombstones written per chunk since the chunk was last rewritten
+ * Counts up in deleteBlock() and is cleared whenever the chunk is saved whole or compacted, so a chunk is only queued
+ * for compaction again once it collects new tombstones. The caller must hold regionMutex().
+ */
+std::map<std::pair<int, int>, size_t> &ChunkLoader::tombstones() {
+    static std::map<std::pair<int, int>, size_t> counts;
+    return counts;
+}
+
+/**
+ * @brief Finds the region file that holds a chunk, opening it the first time it is needed
+ * Regions stay open for the rest of the game so their chunk tables only have to be read once.
+ * The caller must hold regionMutex().
  *
- * @param position Position of the block being written.
- * @param block_id Block Identity.
- * @param x X position
- * @param z Z position
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @return Region that holds the chunk
  */
-void ChunkLoader::writeFile(glm::vec3 position, int block_id, int x, int z) {
+RegionFile &ChunkLoader::region(int chunk_x, int chunk_z) {
+    static std::map<std::pair<int, int>, std::unique_ptr<RegionFile>> regions;
+    std::pair<int, int> key(regionCoord(chunk_x), regionCoord(chunk_z));
+    auto itr = regions.find(key);
+    if (itr == regions.end())
+        itr = regions.emplace(key, std::make_unique<RegionFile>(RegionFile::findFile(key.first, key.second))).first;
+    return *itr->second;
+}
+
+/**
+ * @brief Converts a chunk position into the position of the region that holds it
+ * @param chunk Chunk position
+ * @return Region position
+ */
+int ChunkLoader::regionCoord(int chunk) {
+    return (chunk < 0) ? (chunk + 1) / REGION_SIZE - 1 : chunk / REGION_SIZE;
+}
+
+/**
+ * @brief Converts a chunk position into its position inside its region
+ * @param chunk Chunk position
+ * @return Position in the range [0, REGION_SIZE)
+ */
+int ChunkLoader::regionLocal(int chunk) {
+    return chunk - regionCoord(chunk) * REGION_SIZE;
+}
+
+/**
+ * @brief Converts a world X or Z position into the position of the chunk that holds it
+ * Every chunk covers exactly CHUNK_SIZE blocks, so negative positions round down instead of towards zero.
+ *
+ * @param world World position
+ * @return Chunk position
+ */
+int ChunkLoader::chunkCoord(int world) {
+    return (world < 0) ? (world + 1) / CHUNK_SIZE - 1 : world / CHUNK_SIZE;
+}
+
+/**
+ * @brief Packs a block into the binary format used in the save files
+ * @param position Position of the block
+ * @param block_id Block Identity
+ * @return Encoded block
+ */
+BlockInfo ChunkLoader::encodeBlock(glm::vec3 position, int block_id) {
     // // NEG        Y          X          Z          ID        ATTR/RESERVED
     // // 63 -- 62 | 61 -- 55 | 54 -- 35 | 34 -- 15 | 14 -- 8 | 7 -- 0
-    std::string file = findFile(x, z, false);
-    std::string line;
-    std::fstream  ofs(file, std::ios::app | std::ios::binary);
-    if(!ofs.is_open()) std::cerr << "Save file not open! " << file << std::endl;
+    int x = (int)round(position.x);
+    int z = (int)round(position.z);
     // NEG
     uint64_t x_ = (x < 0) ? 1 : 0;
     uint64_t z_ = (z < 0) ? 1 : 0;
@@ -79,92 +212,261 @@ void ChunkLoader::writeFile(glm::vec3 position, int block_id, int x, int z) {
     x = abs(x);
     z = abs(z);
     BlockInfo encode_b{attr, (uint64_t)block_id, static_cast<uint64_t>(z), static_cast<uint64_t>(x), y, z_, x_};
-    std::bitset<64> binary_value(encode_b.result);
-    ofs.write((char *)&encode_b, sizeof(BlockInfo));
-    ofs.close();
-    if (!ofs.good()) {
-        std::cerr << "Error occurred at writing time!" << std::endl;
-    }else{
-        std::cerr << "Writing: " << block_id << ' ' << position.x << ' ' << position.z << std::endl;
+    return encode_b;
+}
+
+/**
+ * @brief Unpacks a block from the binary format used in the save files
+ * @param block_info Encoded block
+ * @return Decoded block
+ */
+Block ChunkLoader::decodeBlock(const BlockInfo &block_info) {
+    glm::vec3 position;
+    int64_t x = block_info.bits.x;
+    int64_t z = block_info.bits.z;
+
+    x = (block_info.bits.x_) ? -x : x;
+    z = (block_info.bits.z_) ? -z : z;
+
+    position.x = x;
+    position.y = block_info.bits.y;
+    position.z = z;
+    return Block(position, (int)block_info.bits.id);
+}
+
+/**
+ * @brief writes a block into a file in binary format
+ * Takes values of a blocks properties and appends them to the chunk in its region file
+ *
+ * @param position Position of the block being written.
+ * @param block_id Block Identity.
+ * @param x X position
+ * @param z Z position
+ */
+void ChunkLoader::writeFile(glm::vec3 position, int block_id, int x, int z) {
+    int chunk_x = chunkCoord(x);
+    int chunk_z = chunkCoord(z);
+    BlockInfo encode_b = encodeBlock(glm::vec3(x, position.y, z), block_id);
+    std::lock_guard<std::mutex> lock(regionMutex());
+    RegionFile &file = region(chunk_x, chunk_z);
+    if (!file.appendChunk(regionLocal(chunk_x), regionLocal(chunk_z), (const char *)&encode_b, sizeof(BlockInfo))) {
+        std::cerr << "Save file not open! " << file.getPath() << std::endl;
+        return;
+    }
+    stats().blocks_written++;
+    stats().bytes_written += sizeof(BlockInfo);
+    stats().write_calls++;
+}
+
+/**
+ * @brief Writes a whole chunk worth of blocks at once
+ * The blocks are added to the chunk with a single write, instead of one write per block like writeFile.
+ *
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param blocks Encoded blocks or runs of blocks, all of which must lie inside the chunk
+ */
+void ChunkLoader::writeChunk(int chunk_x, int chunk_z, const std::vector<BlockInfo> &blocks) {
+    PROFILE_SCOPE("ChunkLoader::writeChunk");
+    if (blocks.empty()) return;
+    uint32_t size = blocks.size() * sizeof(BlockInfo);
+    std::lock_guard<std::mutex> lock(regionMutex());
+    RegionFile &file = region(chunk_x, chunk_z);
+    if (!file.appendChunk(regionLocal(chunk_x), regionLocal(chunk_z), (const char *)blocks.data(), size)) {
+        std::cerr << "Save file not open! " << file.getPath() << std::endl;
+        return;
+    }
+    stats().chunks_written++;
+    for (const BlockInfo &record : blocks) stats().blocks_written += (record.bits.attr >> ATTR_RUN_SHIFT) + 1;
+    stats().bytes_written += size;
+    stats().write_calls++;
+}
+
+/**
+ * @brief Replaces everything saved for a chunk with the blocks it holds now
+ * @param chunk Chunk to save
+ */
+void ChunkLoader::saveChunk(const Chunk &chunk) {
+    std::vector<BlockInfo> records;
+    encodeChunk(chunk, records);
+
+    uint32_t size = records.size() * sizeof(BlockInfo);
+    std::lock_guard<std::mutex> lock(regionMutex());
+    RegionFile &file = region(chunk.getX(), chunk.getZ());
+    if (!file.writeChunk(regionLocal(chunk.getX()), regionLocal(chunk.getZ()), (const char *)records.data(), size)) {
+        std::cerr << "Save file not open! " << file.getPath() << std::endl;
+        return;
     }
+    tombstones().erase({chunk.getX(), chunk.getZ()});
+    stats().chunks_written++;
+    stats().blocks_written += chunk.getBlockCount();
+    stats().bytes_written += size;
+    stats().write_calls++;
 }
 
-//  from the original file and copies everything else into a new file which replaces the original at the end
 /**
  * @brief Deletes a block from the save files
- * ReWrites the original file of the block except the block that needs to be deleted then deletes the original file,
- * replaces the original file with the new file, and then renames the new file back to the orignial file name
+ * Appends a tombstone record for the block to its chunk instead of rewriting the chunk, so deleting a block is a
+ * single small write. Chunks that collect enough tombstones are compacted later on a background thread.
  *
  * @param block Position of the Block
  * @param block_id Block Identity
- * @param file File that holds the block
  */
-void ChunkLoader::deleteBlock(glm::vec3 block, int block_id, const std::string& file) {
-    std::ifstream iof(file);
-    std::string temp = "temp.txt";
-    std::ofstream iofs(temp);
+void ChunkLoader::deleteBlock(glm::vec3 block, int block_id) {
+    int chunk_x = chunkCoord((int)round(block.x));
+    int chunk_z = chunkCoord((int)round(block.z));
+    BlockInfo encode_b = encodeBlock(block, block_id);
+    encode_b.bits.attr |= ATTR_TOMBSTONE;
 
-    if (!iof.is_open()) {
-        std::cerr << "db: Cannot Read File: " << file << std::endl;
-        return;
-    }
-    else
-        std::cerr << "File Open: " << file << std::endl;
-    if (!iofs.is_open()) {
-        std::cerr << "db: Cannot Read File: " << temp << std::endl;
+    std::lock_guard<std::mutex> lock(regionMutex());
+    RegionFile &file = region(chunk_x, chunk_z);
+    if (!file.appendChunk(regionLocal(chunk_x), regionLocal(chunk_z), (const char *)&encode_b, sizeof(BlockInfo))) {
+        std::cerr << "db: Cannot Write Chunk: " << findFile(chunk_x, chunk_z, true) << std::endl;
         return;
     }
-    else {
-        std::cerr << "File Open: "<< temp << std::endl;
+    stats().bytes_written += sizeof(BlockInfo);
+    stats().write_calls++;
+    // Each tombstone also shadows the record it deletes.
+    size_t &count = tombstones()[{chunk_x, chunk_z}];
+    if (++count * 2 >= COMPACT_THRESHOLD) {
+        requestCompaction(chunk_x, chunk_z, count * 2);
+        count = 0;
     }
-    std::unordered_set<Block> tmp;
-    readFile(file, tmp);
-    tmp.erase(Block(block,block_id));
-    iof.close();
-    std::remove(file.c_str());
-    for(auto itr : tmp){
-        writeFile(itr.getPosition(), itr.getBlockType(), itr.getPosition().x, itr.getPosition().z);
+}
+
+/**
+ * @brief Packs the blocks of a chunk into as few records as possible
+ * Every column is written bottom to top as runs of the same block, so a column of stone is a single record.
+ *
+ * @param chunk Chunk to pack
+ * @param records Receives the records
+ */
+void ChunkLoader::encodeChunk(const Chunk &chunk, std::vector<BlockInfo> &records) {
+    constexpr int LAYER = CHUNK_SIZE * CHUNK_SIZE;
+    records.clear();
+    int origin_x = chunk.getX() * CHUNK_SIZE;
+    int origin_z = chunk.getZ() * CHUNK_SIZE;
+    int top = chunk.getTop();
+    std::vector<int> blocks(top * LAYER);
+    chunk.unpack(blocks.data(), top);
+
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            const int *column = blocks.data() + z * CHUNK_SIZE + x;
+            for (int y = 0; y < top;) {
+                int block_id = column[y * LAYER];
+                if (block_id == AIR) {
+                    y++;
+                    continue;
+                }
+                int run = 1;
+                while (y + run < top && run < MAX_RUN && column[(y + run) * LAYER] == block_id) run++;
+                BlockInfo record = encodeBlock(glm::vec3(origin_x + x, y, origin_z + z), block_id);
+                record.bits.attr = (uint64_t)(run - 1) << ATTR_RUN_SHIFT;
+                records.push_back(record);
+                y += run;
+            }
+        }
     }
 }
+
 /**
- * @brief Reads a file and stores the blocks into an unordered sets
- * Reads a binary file and decodes it and stores the decoded info into an unordered set
+ * @brief Plays back the records of a chunk into dense storage in the order they were written
+ * A later record for a position replaces an earlier one and a tombstone removes it. The records are played into a
+ * plain array of block ids first and the chunk is packed from it at the end.
  *
- * @param file File that needs to be read
- * @param p unordered set to be passed in by reference
+ * @param payload Raw chunk payload
+ * @param chunk Empty chunk the blocks are set in
+ * @return Number of records that no longer have any effect, counting a record as dead when any of it is replaced
  */
-void ChunkLoader::readFile(std::string file, std::unordered_set<Block> & p) {
-    std::vector<std::string > chunks;
-    glm::vec3 position;
-    std::string l, data;
-    std::vector<float> line_data;
+size_t ChunkLoader::replayChunk(const std::vector<char> &payload, Chunk &chunk) {
+    constexpr int LAYER = CHUNK_SIZE * CHUNK_SIZE;
+    size_t records = payload.size() / sizeof(BlockInfo);
+    size_t dead_records = 0;
+    std::vector<int> blocks(Chunk::HEIGHT * LAYER, AIR);
+    int top = 0;
+
     BlockInfo decode_b;
-    std::ifstream ifs(file, std::ios::out | std::ios::binary);
-    if(!ifs.is_open())
-        std::cerr << "Cannot Read File: " << file << std::endl;
-
-    while (ifs.read((char *)&decode_b, sizeof (decode_b))) {
-        // DECODE Binary Files
-        int64_t x = decode_b.bits.x;
-        int64_t z = decode_b.bits.z;
-
-        x = (decode_b.bits.x_) ? -x : x;
-        z = (decode_b.bits.z_) ? -z : z;
-
-        position.x = x;
-        position.y = decode_b.bits.y;
-        position.z = z;
-        // inserts into unordered set
-        p.insert(Block(position, (int) decode_b.bits.id));
-        std::memset(&decode_b, 0, sizeof(decode_b));
+    for (size_t i = 0; i < records; i++) {
+        std::memcpy(&decode_b, payload.data() + i * sizeof(BlockInfo), sizeof(BlockInfo));
+        glm::vec3 position = decodeBlock(decode_b).getPosition();
+        int y = (int)position.y;
+        int *column = blocks.data() + Chunk::toLocal((int)position.z) * CHUNK_SIZE + Chunk::toLocal((int)position.x);
+        bool replaces = column[y * LAYER] != AIR;
+        if (decode_b.bits.attr & ATTR_TOMBSTONE) {
+            // The tombstone is dead once it has removed its block, and so is the record it removed
+            dead_records += replaces ? 2 : 1;
+            column[y * LAYER] = AIR;
+        }
+        else {
+            dead_records += replaces;
+            int end = std::min(Chunk::HEIGHT, y + (int)(decode_b.bits.attr >> ATTR_RUN_SHIFT) + 1);
+            for (int run = y; run < end; run++) column[run * LAYER] = decode_b.bits.id;
+            top = std::max(top, end);
+        }
+    }
+    top = (top + CHUNK_SIZE - 1) / CHUNK_SIZE * CHUNK_SIZE;
+    chunk.assign(blocks.data(), top);
+    return dead_records;
+}
+
+/**
+ * @brief Queues a chunk for background compaction if enough of its records are dead
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param dead_records Number of records that no longer have any effect
+ */
+void ChunkLoader::requestCompaction(int chunk_x, int chunk_z, size_t dead_records) {
+    if (dead_records < COMPACT_THRESHOLD) return;
+    static ChunkCompactor compactor(compactChunk);
+    compactor.request(chunk_x, chunk_z);
+}
+
+/**
+ * @brief Rewrites a chunk with only the blocks it holds now, packed into runs
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ */
+void ChunkLoader::compactChunk(int chunk_x, int chunk_z) {
+    PROFILE_SCOPE("ChunkLoader::compactChunk");
+    std::lock_guard<std::mutex> lock(regionMutex());
+    RegionFile &file = region(chunk_x, chunk_z);
+    std::vector<char> payload;
+    if (!file.readChunk(regionLocal(chunk_x), regionLocal(chunk_z), payload)) return;
+    Chunk chunk(chunk_x, chunk_z);
+    if (replayChunk(payload, chunk) == 0) {
+        tombstones().erase({chunk_x, chunk_z});
+        return;
     }
-    if (ifs.eof()) {
-        std::cout << "Reached the end of the file." << std::endl;
-    } else if (ifs.fail()) {
-        std::cerr << "Failed to read the file." << std::endl;
+    std::vector<BlockInfo> records;
+    encodeChunk(chunk, records);
+    if (file.writeChunk(regionLocal(chunk_x), regionLocal(chunk_z), (const char *)records.data(), records.size() * sizeof(BlockInfo))) {
+        tombstones().erase({chunk_x, chunk_z});
+        stats().bytes_written += records.size() * sizeof(BlockInfo);
+        stats().write_calls++;
     }
-    ifs.close();
-    return;
+}
+
+/**
+ * @brief Reads a chunk and stores the blocks into dense chunk storage
+ * Reads the chunk from its region file and plays its records back into the chunk
+ *
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param chunk Chunk to be passed in by reference
+ */
+void ChunkLoader::readFile(int chunk_x, int chunk_z, Chunk &chunk) {
+    PROFILE_SCOPE("ChunkLoader::readFile");
+    std::vector<char> payload;
+    {
+        std::lock_guard<std::mutex> lock(regionMutex());
+        if (!region(chunk_x, chunk_z).readChunk(regionLocal(chunk_x), regionLocal(chunk_z), payload))
+            return;
+    }
+    stats().chunks_read++;
+    stats().bytes_read += payload.size();
+    size_t dead_records = replayChunk(payload, chunk);
+    requestCompaction(chunk_x, chunk_z, dead_records);
 }
 
 /**
@@ -180,11 +482,9 @@ std::string ChunkLoader::findFile(int x, int z, bool true_file) {
     std::string file="Chunk";
     file.append("(");
     if(!true_file) {
-        if (x < 0) file.append(std::to_string((x - 16) / 16));
-        else file.append(std::to_string(x / 16));
+        file.append(std::to_string(chunkCoord(x)));
         file.append(",");
-        if (z < 0) file.append(std::to_string((z - 16) / 16));
-        else file.append(std::to_string(z / 16));
+        file.append(std::to_string(chunkCoord(z)));
     }
     else{
         file.append(std::to_string(x));
@@ -197,14 +497,128 @@ std::string ChunkLoader::findFile(int x, int z, bool true_file) {
 }
 
 /**
- * @brief Checks to see if there is a file or not
- * @param path File name for path
- * @return Returns boolean if the path exists
+ * @brief Checks to see if a chunk has been saved or not
+ * This is a lookup in the in-memory chunk table of the region, it does not touch the disk.
+ *
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @return Returns boolean if the chunk exists
+ */
+bool ChunkLoader::checkFile(int chunk_x, int chunk_z) {
+    std::lock_guard<std::mutex> lock(regionMutex());
+    return region(chunk_x, chunk_z).hasChunk(regionLocal(chunk_x), regionLocal(chunk_z));
+}
+
+/**
+ * @brief Moves chunks saved as one `Chunk(x,z).bin` file per chunk into region files
+ * Blocks are filed by their own position, so chunks written with the old rounding of negative positions end up in
+ * the right chunk. Every region is written to a copy first and the copies replace the regions only once all of them
+ * have been written, then the old files are removed. A failed migration leaves the regions as they were and keeps
+ * the old files, so it can simply be run again. This has to run before any chunk in the directory is loaded.
+ *
+ * @param directory Directory holding the old chunk files
+ * @return Number of chunk files that were migrated
+ */
+int ChunkLoader::migrateChunkFiles(const std::string &directory) {
+    constexpr const char *PENDING_EXTENSION = ".migrating";
+    std::map<std::pair<int, int>, std::vector<BlockInfo>> chunks;
+    std::vector<std::filesystem::path> migrated;
+
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        int old_x, old_z;
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || std::sscanf(name.c_str(), "Chunk(%d,%d).bin", &old_x, &old_z) != 2)
+            continue;
+
+        std::ifstream ifs(entry.path(), std::ios::binary);
+        if (!ifs.is_open()) {
+            std::cerr << "Cannot Read File: " << name << std::endl;
+            continue;
+        }
+        BlockInfo decode_b;
+        while (ifs.read((char *)&decode_b, sizeof(decode_b))) {
+            Block block = decodeBlock(decode_b);
+            chunks[{chunkCoord((int)block.getPosition().x), chunkCoord((int)block.getPosition().z)}].push_back(decode_b);
+        }
+        migrated.push_back(entry.path());
+    }
+    if (migrated.empty()) return 0;
+
+    // Regions being migrated, each opened on a copy of its file that replaces it once every chunk is in
+    std::map<std::pair<int, int>, std::unique_ptr<RegionFile>> regions;
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> pending;
+    auto abandon = [&] {
+        regions.clear();
+        for (const auto &[path, copy] : pending) std::filesystem::remove(copy, error);
+        std::cerr << "Migration failed, keeping the old chunk files." << std::endl;
+        return 0;
+    };
+    for (const auto &[chunk, blocks] : chunks) {
+        std::pair<int, int> key(regionCoord(chunk.first), regionCoord(chunk.second));
+        auto itr = regions.find(key);
+        if (itr == regions.end()) {
+            std::filesystem::path path = std::filesystem::path(directory) / RegionFile::findFile(key.first, key.second);
+            std::filesystem::path copy = path.string() + PENDING_EXTENSION;
+            std::filesystem::remove(copy, error);
+            if (std::filesystem::exists(path)) {
+                std::filesystem::copy_file(path, copy, error);
+                if (error) return abandon();
+            }
+            pending.emplace_back(path, copy);
+            itr = regions.emplace(key, std::make_unique<RegionFile>(copy.string())).first;
+        }
+        if (!itr->second->appendChunk(regionLocal(chunk.first), regionLocal(chunk.second),
+                                      (const char *)blocks.data(), blocks.size() * sizeof(BlockInfo)))
+            return abandon();
+    }
+    regions.clear();
+
+    for (const auto &[path, copy] : pending) {
+        std::filesystem::rename(copy, path, error);
+        if (error) {
+            std::cerr << "Cannot Write File: " << path.string() << std::endl;
+            return abandon();
+        }
+    }
+    for (const auto &path : migrated)
+        std::filesystem::remove(path, error);
+    std::cerr << "Migrated " << migrated.size() << " chunk files into " << chunks.size() << " chunks." << std::endl;
+    return (int)migrated.size();
+}
+
+/**
+ * @brief Reads the seed of the world saved in a directory and generates terrain from it
+ * A world without a seed gets a random one, which is saved next to its region files so the chunks generated later
+ * match the ones generated now. This has to run before any chunk is generated.
+ *
+ * @param directory Directory holding the world
+ * @return Seed of the world
+ */
+TerrainNoise::Seed ChunkLoader::loadSeed(const std::string &directory) {
+    std::filesystem::path path = std::filesystem::path(directory) / SEED_FILE;
+    TerrainNoise::Seed seed;
+    std::ifstream ifs(path);
+    if (!(ifs >> seed)) {
+        seed = std::random_device{}();
+        std::ofstream ofs(path);
+        if (!(ofs << seed << std::endl))
+            std::cerr << "Cannot Write File: " << path.string() << std::endl;
+    }
+    setSeed(seed);
+    return seed;
+}
+
+/**
+ * @brief Generates terrain from a seed, the same seed always gives the same terrain
+ * This has to run before any chunk is generated.
+ *
+ * @param seed Seed of the world
  */
-bool ChunkLoader::checkFile(std::string path) {
-    std::filesystem::path file{path};
-    return std::filesystem::exists(file);
+void ChunkLoader::setSeed(TerrainNoise::Seed seed) {
+    generator() = WorldGenerator(seed);
 }
+
 /**
  * @brief Rounds the values and snaps the block into an integer value
  * @param position Position of the block
@@ -218,56 +632,25 @@ void ChunkLoader::placeCube(glm::vec3 position, int block_type) {
 }
 
 /**
- * @brief Uses a perlin noise generator to find an appropriate Y value
- * @param start_pos_x X position
- * @param start_pos_z Z position
+ * @brief Generates every block of a chunk that has never been saved and saves it with a single write
+ * @param chunk Empty chunk at the position to generate, filled with the generated blocks
+ * @param pool Workers to share the generation of the chunk with, or nullptr to generate it on the calling thread
  */
-void ChunkLoader::updateTerrain(int start_pos_x, int start_pos_z) {
-    float h = perlin((float)(start_pos_x - 20) * 0.15f, (float)(start_pos_z - 20) * 0.15f);
-    if (h > water_level)
-        placeCube(glm::vec3(start_pos_x, h, start_pos_z), GRASS);
-    else
-        placeCube(glm::vec3(start_pos_x, water_level, start_pos_z), WATER);
+void ChunkLoader::generateChunk(Chunk &chunk, WorkerPool *pool) {
+    PROFILE_SCOPE("ChunkLoader::generateChunk");
+    generator().generateChunk(chunk, pool);
+    std::vector<BlockInfo> records;
+    encodeChunk(chunk, records);
+    writeChunk(chunk.getX(), chunk.getZ(), records);
 }
 
 /**
- * @brief Finds the quadrant that the blocks need to be and calls the updateTerrain function
- * @param relative_x Relative X value to start writing a chunk
- * @param relative_z Relative Z value to start writing a chunk
+ * @brief Generates a chunk that has never been saved and saves it without keeping the blocks
+ * @param relative_x X position of the chunk
+ * @param relative_z Z position of the chunk
  */
 void ChunkLoader::updateChunk(int relative_x, int relative_z) {
-    std::fstream ofs(findFile(relative_x, relative_z, true), std::ios::app);
-    if (relative_x >= 0 && relative_z >= 0) {    // first quadrant
-        for (int i = relative_x * 16; i < (relative_x + 1) * 16; i++) {
-            for (int j = relative_z * 16; j < (relative_z + 1) * 16; j++) {
-                updateTerrain(i, j);
-            }
-        }
-    }
-    else if (relative_x < 0 && relative_z >= 0) {     // second quadrant
-        for (int i = (relative_x + 1) * 16; i > relative_x * 16; i--) {
-            for (int j = relative_z * 16; j < (relative_z + 1) * 16; j++) {
-                if (i == 0) continue;
-                updateTerrain(i, j);
-            }
-        }
-    }
-    else if (relative_x < 0 && relative_z < 0) {     // third quadrant
-        for (int i = (relative_x + 1) * 16; i > relative_x * 16; i--) {
-            for (int j = (relative_z + 1) * 16; j > relative_z * 16; j--) {
-                if (i == 0 || j == 0) continue;
-                updateTerrain(i, j);
-            }
-        }
-    }
-    else if (relative_x >= 0 && relative_z < 0) {     // fourth quadrant
-        for (int i = relative_x * 16; i < (relative_x + 1) * 16; i++) {
-            for (int j = (relative_z + 1) * 16; j > relative_z * 16; j--) {
-                if (j == 0)continue;
-                updateTerrain(i, j);
-            }
-        }
-    }
-    ofs.close();
+    Chunk chunk(relative_x, relative_z);
+    generateChunk(chunk);
 }
 #endif
@@ -0,0 +1,172 @@
+#ifndef CHUNKMAP_H
+#define CHUNKMAP_H
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Hash map from chunk positions to chunk data
+ * Positions are packed into a single 64 bit key and stored with open addressing and linear probing, so a lookup is
+ * a hash and a short scan of one array without building strings or allocating. Erasing shifts the following
+ * entries back instead of leaving tombstones, so lookups stay short after chunks are unloaded.
+ *
+ * @tparam T Data stored per chunk, must be default constructible and movable
+ */
+template<class T>
+class ChunkMap {
+private:
+    struct Slot {
+        uint64_t key = 0;
+        bool occupied = false;
+        T value{};
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    static uint64_t hash(uint64_t key) {
+        // splitmix64 finalizer, spreads neighbouring chunk positions across the table
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key;
+    }
+
+    size_t mask() const { return slots.size() - 1; }
+
+    /**
+     * @brief Finds the slot that holds a key, or the empty slot where it would be inserted
+     */
+    size_t probe(uint64_t key) const {
+        size_t i = hash(key) & mask();
+        while (slots[i].occupied && slots[i].key != key) i = (i + 1) & mask();
+        return i;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old = std::move(slots);
+        slots = std::vector<Slot>(capacity);
+        for (Slot &slot : old) {
+            if (!slot.occupied) continue;
+            Slot &target = slots[probe(slot.key)];
+            target.key = slot.key;
+            target.occupied = true;
+            target.value = std::move(slot.value);
+        }
+    }
+
+public:
+    explicit ChunkMap(size_t capacity = 64) {
+        size_t size = 16;
+        while (size < capacity) size *= 2;
+        slots.resize(size);
+    }
+
+    /**
+     * @brief Packs a chunk position into a map key
+     */
+    static uint64_t key(int chunk_x, int chunk_z) {
+        return ((uint64_t)(uint32_t)chunk_x << 32) | (uint32_t)chunk_z;
+    }
+
+    static int keyX(uint64_t key) { return (int)(uint32_t)(key >> 32); }
+    static int keyZ(uint64_t key) { return (int)(uint32_t)key; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * @brief Looks up a chunk
+     * @return Pointer to the chunk data, or nullptr if the chunk is not in the map
+     */
+    T *find(int chunk_x, int chunk_z) {
+        Slot &slot = slots[probe(key(chunk_x, chunk_z))];
+        return slot.occupied ? &slot.value : nullptr;
+    }
+
+    const T *find(int chunk_x, int chunk_z) const {
+        const Slot &slot = slots[probe(key(chunk_x, chunk_z))];
+        return slot.occupied ? &slot.value : nullptr;
+    }
+
+    bool contains(int chunk_x, int chunk_z) const {
+        return find(chunk_x, chunk_z) != nullptr;
+    }
+
+    /**
+     * @brief Adds a chunk, replacing the data if the chunk is already in the map
+     * @return Reference to the stored chunk data
+     */
+    T &insert(int chunk_x, int chunk_z, T value) {
+        // Keep the table at most 3/4 full so probe sequences stay short.
+        if ((count + 1) * 4 > slots.size() * 3) rehash(slots.size() * 2);
+        uint64_t k = key(chunk_x, chunk_z);
+        Slot &slot = slots[probe(k)];
+        if (!slot.occupied) {
+            slot.key = k;
+            slot.occupied = true;
+            count++;
+        }
+        slot.value = std::move(value);
+        return slot.value;
+    }
+
+    /**
+     * @brief Removes a chunk
+     * @return True if the chunk was in the map
+     */
+    bool erase(int chunk_x, int chunk_z) {
+        size_t i = probe(key(chunk_x, chunk_z));
+        if (!slots[i].occupied) return false;
+        slots[i].occupied = false;
+        slots[i].value = T{};
+        count--;
+
+        // Move later entries of the same probe run back into the hole so lookups never stop early.
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask(); slots[j].occupied; j = (j + 1) & mask()) {
+            size_t home = hash(slots[j].key) & mask();
+            if (((j - home) & mask()) < ((j - hole) & mask())) continue;
+            slots[hole].key = slots[j].key;
+            slots[hole].occupied = true;
+            slots[hole].value = std::move(slots[j].value);
+            slots[j].occupied = false;
+            slots[j].value = T{};
+            hole = j;
+        }
+        return true;
+    }
+
+    void clear() {
+        for (Slot &slot : slots) {
+            slot.occupied = false;
+            slot.value = T{};
+        }
+        count = 0;
+    }
+
+    /**
+     * @brief Calls a function for every chunk in the map, in no particular order
+     * @param fn Called as fn(chunk_x, chunk_z, value)
+     */
+    template<class Function>
+    void forEach(Function &&fn) {
+        for (Slot &slot : slots) {
+            if (slot.occupied) fn(keyX(slot.key), keyZ(slot.key), slot.value);
+        }
+    }
+
+    template<class Function>
+    void forEach(Function &&fn) const {
+        for (const Slot &slot : slots) {
+            if (slot.occupied) fn(keyX(slot.key), keyZ(slot.key), slot.value);
+        }
+    }
+};
+
+#endif
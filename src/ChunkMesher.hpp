@@ -0,0 +1,229 @@
+#ifndef CHUNKMESHER_H
+#define CHUNKMESHER_H
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// Header Files
+#include "Chunk.hpp"
+
+/**
+ * @brief Packs a block into one integer for the block shader
+ * Bits 0-3 are X, bits 4-7 are Z and bits 8-14 are Y inside the chunk, and bits 16-31 are the block type, which is
+ * also the layer of the block texture array.
+ */
+inline uint32_t packBlock(int x, int y, int z, int block_type) {
+    return (uint32_t)x | (uint32_t)z << 4 | (uint32_t)y << 8 | (uint32_t)block_type << 16;
+}
+
+/**
+ * @brief Vertex of a chunk mesh, laid out like the cube vertices (position, color, texture coord) plus the block
+ * Positions are relative to the corner of the chunk and blocks are centred on their position like the cube. The
+ * packed block only carries the block type since the position is already in the vertex.
+ */
+struct MeshVertex {
+    float x, y, z;
+    float r, g, b;
+    float u, v;
+    uint32_t block;
+};
+
+/**
+ * @brief Triangles of every visible block face in a chunk
+ */
+struct ChunkMesh {
+    std::vector<MeshVertex> vertices;
+    int quads = 0;
+
+    bool empty() const { return vertices.empty(); }
+};
+
+/**
+ * @brief Blocks of a chunk drawn as instances of the cube, one packed block per instance
+ */
+struct ChunkInstances {
+    std::vector<uint32_t> instances;
+
+    bool empty() const { return instances.empty(); }
+};
+
+/**
+ * @brief Chunks next to the chunk being meshed, nullptr where the neighbour is not loaded
+ */
+struct ChunkNeighbours {
+    const Chunk *neg_x = nullptr;
+    const Chunk *pos_x = nullptr;
+    const Chunk *neg_z = nullptr;
+    const Chunk *pos_z = nullptr;
+
+    /**
+     * @brief Bit for every neighbour that is loaded, so a mesh can tell when it was built without a neighbour
+     */
+    int loaded() const {
+        return (neg_x != nullptr) | (pos_x != nullptr) << 1 | (neg_z != nullptr) << 2 | (pos_z != nullptr) << 3;
+    }
+};
+
+/**
+ * @brief Builds chunk meshes on the CPU with greedy meshing
+ * Faces between two blocks are never seen so they are skipped, including faces against blocks in the neighbouring
+ * chunks. Neighbouring faces that point the same way and have the same block type are merged into one rectangle, so
+ * a flat patch of grass is two triangles instead of two per block. Texture coordinates keep counting up across a
+ * merged face so the texture repeats once per block.
+ *
+ * The mesher only reads the chunks it is given and does not touch OpenGL, so it can run on any thread.
+ */
+class ChunkMesher {
+private:
+    static void addQuad(std::vector<MeshVertex> &vertices, int axis, bool front, const float corner[3],
+                        const float du[3], const float dv[3], int block_type);
+
+public:
+    static ChunkMesh build(const Chunk &chunk, const ChunkNeighbours &neighbours = {});
+    static ChunkInstances buildInstances(const Chunk &chunk, const ChunkNeighbours &neighbours = {});
+};
+
+/**
+ * @brief Adds the two triangles of a rectangle facing along an axis
+ * @param axis 0 for X, 1 for Y, 2 for Z
+ * @param front True if the face points towards positive axis
+ * @param corner Lowest corner of the rectangle
+ * @param du Edge of the rectangle along the next axis
+ * @param dv Edge of the rectangle along the axis after that
+ * @param block_type Block type of the face
+ */
+void ChunkMesher::addQuad(std::vector<MeshVertex> &vertices, int axis, bool front, const float corner[3],
+                          const float du[3], const float dv[3], int block_type) {
+    // Tops are lit the most and bottoms the least, like light from above.
+    float shade = axis == 1 ? (front ? 1.0f : 0.5f) : 0.8f;
+    auto vertex = [&](float a, float b) {
+        float p[3];
+        for (int i = 0; i < 3; i++) p[i] = corner[i] + du[i] * a + dv[i] * b;
+        // Texture coordinates come from the position so the texture lines up with the block grid
+        float u = axis == 0 ? p[2] : p[0];
+        float v = axis == 1 ? p[2] : p[1];
+        return MeshVertex{p[0], p[1], p[2], shade, shade, shade, u + 0.5f, v + 0.5f, packBlock(0, 0, 0, block_type)};
+    };
+    MeshVertex c0 = vertex(0, 0), c1 = vertex(1, 0), c2 = vertex(1, 1), c3 = vertex(0, 1);
+    // du x dv points along the axis, so the corners are counter-clockwise seen from the front
+    if (front) vertices.insert(vertices.end(), {c0, c1, c2, c2, c3, c0});
+    else vertices.insert(vertices.end(), {c0, c3, c2, c2, c1, c0});
+}
+
+/**
+ * @brief Builds the mesh of a chunk
+ * Faces on the border of the chunk are kept where the neighbouring chunk is not loaded, so the mesh has to be built
+ * again when it arrives.
+ *
+ * @param chunk Chunk to mesh
+ * @param neighbours Loaded chunks around it
+ * @return Mesh with positions relative to the corner of the chunk
+ */
+ChunkMesh ChunkMesher::build(const Chunk &chunk, const ChunkNeighbours &neighbours) {
+    ChunkMesh mesh;
+    if (chunk.empty()) return mesh;
+
+    // Everything above the highest section with blocks in it is air, so the sweeps stop there
+    const int DIMS[3] = {Chunk::SIZE, chunk.getTop(), Chunk::SIZE};
+
+    // Unpack the chunk once so the sweeps below are plain array reads
+    std::vector<int> blocks(DIMS[0] * DIMS[1] * DIMS[2], AIR);
+    auto at = [&](const int p[3]) -> int & { return blocks[(p[1] * DIMS[2] + p[2]) * DIMS[0] + p[0]]; };
+    chunk.forEachBlock([&](int x, int y, int z, int block_id) {
+        int p[3] = {x, y, z};
+        at(p) = block_id;
+    });
+
+    std::vector<int> mask;
+    for (int axis = 0; axis < 3; axis++) {
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        mask.assign(DIMS[u] * DIMS[v], AIR);
+        for (int front = 0; front < 2; front++) {
+            for (int slice = 0; slice < DIMS[axis]; slice++) {
+                // Block types of the faces in this slice that are not covered by another block
+                int p[3], q[3];
+                for (int j = 0; j < DIMS[v]; j++) {
+                    for (int i = 0; i < DIMS[u]; i++) {
+                        p[axis] = slice, p[u] = i, p[v] = j;
+                        int block_id = at(p);
+                        int covering = AIR;
+                        q[axis] = slice + (front ? 1 : -1), q[u] = i, q[v] = j;
+                        if (q[axis] >= 0 && q[axis] < DIMS[axis]) {
+                            covering = at(q);
+                        }
+                        else if (axis != 1 && block_id != AIR) {
+                            // The covering block is in the next chunk over
+                            const Chunk *next = axis == 0 ? (front ? neighbours.pos_x : neighbours.neg_x)
+                                                          : (front ? neighbours.pos_z : neighbours.neg_z);
+                            q[axis] = Chunk::toLocal(q[axis]);
+                            if (next != nullptr) covering = next->get(q[0], q[1], q[2]);
+                        }
+                        mask[j * DIMS[u] + i] = covering == AIR ? block_id : AIR;
+                    }
+                }
+
+                // Grow each face as far as it goes along u, then along v while every row matches
+                for (int j = 0; j < DIMS[v]; j++) {
+                    for (int i = 0; i < DIMS[u];) {
+                        int block_id = mask[j * DIMS[u] + i];
+                        if (block_id == AIR) {
+                            i++;
+                            continue;
+                        }
+                        int width = 1;
+                        while (i + width < DIMS[u] && mask[j * DIMS[u] + i + width] == block_id) width++;
+                        int height = 1;
+                        for (; j + height < DIMS[v]; height++) {
+                            bool row = true;
+                            for (int k = 0; k < width && row; k++) row = mask[(j + height) * DIMS[u] + i + k] == block_id;
+                            if (!row) break;
+                        }
+
+                        float corner[3], du[3] = {0, 0, 0}, dv[3] = {0, 0, 0};
+                        corner[axis] = slice + (front ? 0.5f : -0.5f);
+                        corner[u] = i - 0.5f;
+                        corner[v] = j - 0.5f;
+                        du[u] = (float)width;
+                        dv[v] = (float)height;
+                        addQuad(mesh.vertices, axis, front, corner, du, dv, block_id);
+                        mesh.quads++;
+
+                        for (int l = 0; l < height; l++) {
+                            for (int k = 0; k < width; k++) mask[(j + l) * DIMS[u] + i + k] = AIR;
+                        }
+                        i += width;
+                    }
+                }
+            }
+        }
+    }
+    return mesh;
+}
+
+/**
+ * @brief Lists the blocks of a chunk that have at least one face showing, for drawing them as cube instances
+ * @param chunk Chunk to list
+ * @param neighbours Loaded chunks around it
+ * @return Instances in storage order
+ */
+ChunkInstances ChunkMesher::buildInstances(const Chunk &chunk, const ChunkNeighbours &neighbours) {
+    ChunkInstances result;
+    auto block = [&](int x, int y, int z) {
+        if (y < 0 || y >= Chunk::HEIGHT) return AIR;
+        if (x >= 0 && x < Chunk::SIZE && z >= 0 && z < Chunk::SIZE) return chunk.get(x, y, z);
+        const Chunk *next = x < 0 ? neighbours.neg_x : x >= Chunk::SIZE ? neighbours.pos_x
+                          : z < 0 ? neighbours.neg_z : neighbours.pos_z;
+        return next != nullptr ? next->get(Chunk::toLocal(x), y, Chunk::toLocal(z)) : AIR;
+    };
+
+    chunk.forEachBlock([&](int x, int y, int z, int block_type) {
+        if (block(x - 1, y, z) != AIR && block(x + 1, y, z) != AIR && block(x, y - 1, z) != AIR &&
+            block(x, y + 1, z) != AIR && block(x, y, z - 1) != AIR && block(x, y, z + 1) != AIR)
+            return;
+        result.instances.push_back(packBlock(x, y, z, block_type));
+    });
+    return result;
+}
+
+#endif
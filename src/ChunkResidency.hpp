@@ -0,0 +1,113 @@
+#ifndef CHUNKRESIDENCY_H
+#define CHUNKRESIDENCY_H
+
+// Dependencies
+#include "glm/glm.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Header Files
+#include "Chunk.hpp"
+#include "ChunkLoader.hpp"
+#include "ChunkMap.hpp"
+#include "ChunkStreamer.hpp"
+
+/**
+ * @brief Decides which loaded chunks stay in memory
+ * Chunks are loaded inside the render distance but only become unloadable once they are further than the render
+ * distance plus a margin, so walking back and forth over a chunk border does not load and unload the same chunks
+ * every frame. Unloadable chunks are kept as a cache while the world fits in the memory budget, and the least
+ * recently used ones are unloaded first once it does not. Edits are already on the streamer's write lane, so an edited
+ * chunk is not saved again when it is dropped, a later load of it just waits for the edits to reach the disk.
+ *
+ * Every function must be called from the render thread.
+ */
+class ChunkResidency {
+private:
+    struct Entry {
+        uint64_t last_used = 0; // Last frame the chunk was within range
+        bool dirty = false;
+    };
+
+    ChunkMap<Entry> entries;
+    uint64_t frame = 0;
+    size_t resident_chunks = 0;
+    size_t resident_bytes = 0;
+    uint64_t evicted = 0;
+
+public:
+    int unload_margin = 2;                   // Chunks past the render distance that stay loaded
+    size_t memory_budget = 64 * 1024 * 1024; // Bytes of block data kept before unloading chunks
+
+    void markDirty(int chunk_x, int chunk_z);
+    int update(glm::vec3 position, int render_distance, ChunkMap<Chunk> &chunks, ChunkStreamer &streamer);
+
+    size_t residentChunks() const { return resident_chunks; }
+    size_t residentBytes() const { return resident_bytes; }
+    uint64_t getEvicted() const { return evicted; }
+};
+
+/**
+ * @brief Records that a loaded chunk was edited, so loading it again after it is unloaded waits for its edits
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ */
+void ChunkResidency::markDirty(int chunk_x, int chunk_z) {
+    Entry *entry = entries.find(chunk_x, chunk_z);
+    if (entry == nullptr) entry = &entries.insert(chunk_x, chunk_z, Entry{frame, false});
+    entry->dirty = true;
+}
+
+/**
+ * @brief Unloads chunks that are out of range, least recently used first, until the world fits in the memory budget
+ * @param position Camera position
+ * @param render_distance Chunks within this distance are loaded
+ * @param chunks Loaded chunks of the world
+ * @param streamer Streamer that writes the edits
+ * @return Number of chunks unloaded
+ */
+int ChunkResidency::update(glm::vec3 position, int render_distance, ChunkMap<Chunk> &chunks, ChunkStreamer &streamer) {
+    frame++;
+    int center_x = ChunkLoader::chunkCoord((int)std::floor(position.x));
+    int center_z = ChunkLoader::chunkCoord((int)std::floor(position.z));
+    int keep = render_distance + unload_margin;
+
+    // Candidates for unloading as (last used frame, chunk key)
+    std::vector<std::pair<uint64_t, uint64_t>> candidates;
+    resident_bytes = 0;
+    chunks.forEach([&](int chunk_x, int chunk_z, const Chunk &chunk) {
+        resident_bytes += chunk.memoryUsage();
+        Entry *entry = entries.find(chunk_x, chunk_z);
+        if (entry == nullptr) entry = &entries.insert(chunk_x, chunk_z, Entry{frame, false});
+        if (std::abs(chunk_x - center_x) <= keep && std::abs(chunk_z - center_z) <= keep)
+            entry->last_used = frame;
+        else
+            candidates.emplace_back(entry->last_used, ChunkMap<Chunk>::key(chunk_x, chunk_z));
+    });
+    resident_chunks = chunks.size();
+    if (resident_bytes <= memory_budget || candidates.empty()) return 0;
+
+    std::sort(candidates.begin(), candidates.end());
+    int unloaded = 0;
+    for (const auto &[last_used, key] : candidates) {
+        if (resident_bytes <= memory_budget) break;
+        int chunk_x = ChunkMap<Chunk>::keyX(key), chunk_z = ChunkMap<Chunk>::keyZ(key);
+        Chunk *chunk = chunks.find(chunk_x, chunk_z);
+        Entry *entry = entries.find(chunk_x, chunk_z);
+        if (entry->dirty) streamer.fence(chunk_x, chunk_z);
+        resident_bytes -= chunk->memoryUsage();
+        resident_chunks--;
+        chunks.erase(chunk_x, chunk_z);
+        entries.erase(chunk_x, chunk_z);
+        unloaded++;
+    }
+    evicted += unloaded;
+    return unloaded;
+}
+
+#endif
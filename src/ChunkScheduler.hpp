@@ -0,0 +1,144 @@
+#ifndef CHUNKSCHEDULER_H
+#define CHUNKSCHEDULER_H
+
+// Dependencies
+#include "glm/glm.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Header Files
+#include "Chunk.hpp"
+#include "ChunkLoader.hpp"
+#include "ChunkMap.hpp"
+#include "ChunkStreamer.hpp"
+
+/**
+ * @brief Decides which chunks the streamer works on next
+ * Every frame the scheduler collects the chunks around the player that still need loading or generating, orders
+ * them nearest first with chunks in front of the camera ahead of chunks behind it, and hands the cheapest ones to
+ * the streamer while keeping only a few requests in flight. Requests are rebuilt from the player's surroundings every
+ * frame, so a chunk is never queued twice and chunks the player has moved away from drop out of the queue. Requests
+ * already handed to the streamer are cancelled when they fall out of range.
+ *
+ * The scheduler never touches the region files, a frame would otherwise wait on any worker holding them. Chunks are
+ * only left out of the buffer ring once a worker has reported them saved, and a worker that is handed a chunk that
+ * is already saved just reports it.
+ */
+class ChunkScheduler {
+public:
+    struct Request {
+        int chunk_x;
+        int chunk_z;
+        bool load;  // False for chunks that are only generated to disk ahead of time
+        float cost; // Lower is sooner
+    };
+
+private:
+    std::vector<Request> queue;
+    uint64_t cancelled = 0;
+    uint64_t dispatched = 0;
+
+public:
+    static float cost(glm::vec3 position, glm::vec3 front, int chunk_x, int chunk_z);
+
+    void update(glm::vec3 position, glm::vec3 front, int render_distance, int buffer, const ChunkMap<Chunk> &loaded,
+                ChunkStreamer &streamer);
+    int dispatch(ChunkStreamer &streamer, size_t max_in_flight);
+
+    const std::vector<Request> &getQueue() const { return queue; }
+    size_t waiting() const { return queue.size(); }
+    // Requests waiting in the scheduler plus requests the streamer is working on
+    size_t queueDepth(const ChunkStreamer &streamer) const { return queue.size() + streamer.pending(); }
+    uint64_t getCancelled() const { return cancelled; }
+    uint64_t getDispatched() const { return dispatched; }
+};
+
+/**
+ * @brief Cost of loading a chunk next, the distance to the player weighted by where the camera is looking
+ * Chunks straight ahead cost their distance and chunks straight behind cost one and a half times their distance.
+ *
+ * @param position Camera position
+ * @param front Camera direction
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ */
+float ChunkScheduler::cost(glm::vec3 position, glm::vec3 front, int chunk_x, int chunk_z) {
+    float dx = (chunk_x + 0.5f) * ChunkLoader::CHUNK_SIZE - position.x;
+    float dz = (chunk_z + 0.5f) * ChunkLoader::CHUNK_SIZE - position.z;
+    float distance = std::sqrt(dx * dx + dz * dz);
+    float forward = std::sqrt(front.x * front.x + front.z * front.z);
+    if (distance < 1e-3f || forward < 1e-3f) return distance;
+    float facing = (dx * front.x + dz * front.z) / (distance * forward);
+    return distance * (1.25f - 0.25f * facing);
+}
+
+/**
+ * @brief Rebuilds the queue from the chunks around the player and cancels requests that are out of range
+ * @param position Camera position
+ * @param front Camera direction
+ * @param render_distance Chunks within this distance are loaded
+ * @param buffer Chunks this much further out are generated to disk but not loaded
+ * @param loaded Chunks that are already in the world
+ * @param streamer Streamer that runs the requests
+ */
+void ChunkScheduler::update(glm::vec3 position, glm::vec3 front, int render_distance, int buffer,
+                            const ChunkMap<Chunk> &loaded, ChunkStreamer &streamer) {
+    int center_x = ChunkLoader::chunkCoord((int)std::floor(position.x));
+    int center_z = ChunkLoader::chunkCoord((int)std::floor(position.z));
+    int range = render_distance + buffer;
+
+    std::vector<std::pair<int, int>> out_of_range;
+    streamer.forEachPending([&](int chunk_x, int chunk_z) {
+        if (std::abs(chunk_x - center_x) > range || std::abs(chunk_z - center_z) > range)
+            out_of_range.emplace_back(chunk_x, chunk_z);
+    });
+    for (const auto &[chunk_x, chunk_z] : out_of_range) {
+        if (streamer.cancel(chunk_x, chunk_z)) cancelled++;
+    }
+
+    // Forget saved chunks well out of range once there are a lot more of them than the area around the player holds
+    size_t area = (size_t)(2 * range + 1) * (2 * range + 1);
+    if (streamer.savedCount() > 8 * area) streamer.forgetSaved(center_x, center_z, 2 * range);
+
+    queue.clear();
+    for (int i = -range; i <= range; i++) {
+        for (int j = -range; j <= range; j++) {
+            int chunk_x = center_x + i, chunk_z = center_z + j;
+            if (loaded.contains(chunk_x, chunk_z) || streamer.isPending(chunk_x, chunk_z))
+                continue;
+            bool load = std::abs(i) <= render_distance && std::abs(j) <= render_distance;
+            if (!load && streamer.isSaved(chunk_x, chunk_z))
+                continue;
+            queue.push_back({chunk_x, chunk_z, load, cost(position, front, chunk_x, chunk_z)});
+        }
+    }
+    std::sort(queue.begin(), queue.end(), [](const Request &a, const Request &b) { return a.cost < b.cost; });
+}
+
+/**
+ * @brief Hands the cheapest requests to the streamer
+ * Keeping few requests in flight means a request made when the player turns or moves is not stuck behind a long
+ * list of requests that were made earlier.
+ *
+ * @param streamer Streamer that runs the requests
+ * @param max_in_flight Most requests the streamer may be working on at once
+ * @return Number of requests handed to the streamer
+ */
+int ChunkScheduler::dispatch(ChunkStreamer &streamer, size_t max_in_flight) {
+    size_t next = 0;
+    while (next < queue.size() && streamer.pending() < max_in_flight) {
+        const Request &request = queue[next++];
+        if (request.load) streamer.requestLoad(request.chunk_x, request.chunk_z);
+        else streamer.requestGenerate(request.chunk_x, request.chunk_z);
+    }
+    queue.erase(queue.begin(), queue.begin() + next);
+    dispatched += next;
+    return (int)next;
+}
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef CHUNKSTREAMER_H
+#define CHUNKSTREAMER_H
+
+// STL
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Header Files
+#include "Chunk.hpp"
+#include "ChunkLoader.hpp"
+#include "ChunkMap.hpp"
+
+// Utilities
+#include "utils/LockFreeQueue.hpp"
+#include "utils/WorkerPool.hpp"
+
+/**
+ * @brief Generates, loads and saves chunks on a pool of worker threads
+ * The render thread requests chunks, workers generate them if they have never been saved and read them into dense
+ * storage, and finished chunks come back through a lock-free queue. integrate() moves finished chunks into the world
+ * until its time budget runs out, so a frame never waits on disk or on terrain generation.
+ *
+ * Writes (block edits and whole chunk saves) go through a single ordered lane so they reach the disk in the order
+ * they were requested, whichever worker runs them.
+ *
+ * Every function except the queued jobs must be called from the render thread.
+ */
+class ChunkStreamer {
+private:
+    // Finished work handed back to the render thread
+    struct Result {
+        Chunk chunk;
+        bool loaded = false; // False for chunks that were only generated to disk
+        bool saved = false;  // The worker found the chunk on disk or generated it
+    };
+
+    constexpr static size_t COMPLETED_CAPACITY = 256;
+
+    LockFreeQueue<Result> completed{COMPLETED_CAPACITY};
+    // Chunks requested but not integrated yet, with the flag that cancels them. Render thread only.
+    ChunkMap<std::shared_ptr<std::atomic<bool>>> in_flight;
+    std::atomic<bool> shutting_down{false};
+
+    std::mutex write_mutex;
+    std::deque<std::function<void()>> writes;
+    bool writing = false;
+    uint64_t writes_requested = 0; // Render thread only
+    std::atomic<uint64_t> writes_done{0};
+    // Number of writes that had been requested when each chunk was last saved or edited. Render thread only.
+    ChunkMap<uint64_t> saves;
+    // Chunks a worker has found on disk or generated, so the render thread never has to ask the region files.
+    // Render thread only.
+    ChunkMap<bool> saved_chunks;
+
+    // Declared last so the workers are joined before anything they use is destroyed.
+    WorkerPool pool;
+
+    void complete(Result &&result);
+    std::shared_ptr<std::atomic<bool>> track(int chunk_x, int chunk_z);
+    bool isSaving(int chunk_x, int chunk_z);
+    void drainWrites();
+
+public:
+    explicit ChunkStreamer(unsigned threads = WorkerPool::defaultThreadCount()) : pool(threads) {}
+    ~ChunkStreamer();
+
+    bool requestLoad(int chunk_x, int chunk_z);
+    bool requestGenerate(int chunk_x, int chunk_z);
+    void requestWrite(std::function<void()> write);
+    void requestSave(const Chunk &chunk);
+    void fence(int chunk_x, int chunk_z);
+    bool cancel(int chunk_x, int chunk_z);
+    int integrate(ChunkMap<Chunk> &chunks, double budget_ms);
+
+    void forgetSaved(int center_x, int center_z, int range);
+
+    bool isPending(int chunk_x, int chunk_z) const { return in_flight.contains(chunk_x, chunk_z); }
+    bool isSaved(int chunk_x, int chunk_z) const { return saved_chunks.contains(chunk_x, chunk_z); }
+    size_t savedCount() const { return saved_chunks.size(); }
+    size_t pending() const { return in_flight.size(); }
+    unsigned threadCount() const { return pool.size(); }
+
+    /**
+     * @brief Calls a function for every chunk that has been requested but not integrated yet
+     * @param fn Called as fn(chunk_x, chunk_z)
+     */
+    template<class Function>
+    void forEachPending(Function &&fn) const {
+        in_flight.forEach([&](int chunk_x, int chunk_z, const std::shared_ptr<std::atomic<bool>> &) { fn(chunk_x, chunk_z); });
+    }
+};
+
+ChunkStreamer::~ChunkStreamer() {
+    // Workers waiting for room in the completed queue give up instead of blocking the shutdown.
+    shutting_down = true;
+}
+
+/**
+ * @brief Hands a finished chunk back to the render thread, waiting for room if the queue is full
+ */
+void ChunkStreamer::complete(Result &&result) {
+    while (!completed.tryPush(std::move(result))) {
+        if (shutting_down) return;
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Marks a chunk as in flight
+ * @return Flag that cancels the request when set
+ */
+std::shared_ptr<std::atomic<bool>> ChunkStreamer::track(int chunk_x, int chunk_z) {
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    in_flight.insert(chunk_x, chunk_z, cancelled);
+    return cancelled;
+}
+
+/**
+ * @brief Checks whether a save or edit of a chunk is still waiting on the write lane
+ * A chunk that is loaded while its writes are queued would be read as it was before them.
+ */
+bool ChunkStreamer::isSaving(int chunk_x, int chunk_z) {
+    uint64_t *ticket = saves.find(chunk_x, chunk_z);
+    if (ticket == nullptr) return false;
+    if (*ticket > writes_done.load()) return true;
+    saves.erase(chunk_x, chunk_z);
+    return false;
+}
+
+/**
+ * @brief Cancels a load or generate request if a worker has not started it yet
+ * The chunk stays pending until the cancelled request has been handed back through integrate().
+ *
+ * @return False if the chunk was not requested or has already been cancelled
+ */
+bool ChunkStreamer::cancel(int chunk_x, int chunk_z) {
+    std::shared_ptr<std::atomic<bool>> *cancelled = in_flight.find(chunk_x, chunk_z);
+    if (cancelled == nullptr) return false;
+    return !(*cancelled)->exchange(true);
+}
+
+/**
+ * @brief Generates a chunk if it has never been saved and loads it into dense storage on a worker
+ * If the chunk still has a save queued the load is queued behind it on the write lane.
+ *
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @return False if the chunk has already been requested
+ */
+bool ChunkStreamer::requestLoad(int chunk_x, int chunk_z) {
+    if (in_flight.contains(chunk_x, chunk_z)) return false;
+    std::function<void()> load = [this, chunk_x, chunk_z, cancelled = track(chunk_x, chunk_z)] {
+        if (shutting_down) return;
+        Result result;
+        result.chunk = Chunk(chunk_x, chunk_z);
+        if (*cancelled) {
+            complete(std::move(result));
+            return;
+        }
+        // A chunk that was just generated is already in dense storage, so it is not read back
+        if (!ChunkLoader::checkFile(chunk_x, chunk_z))
+            ChunkLoader::generateChunk(result.chunk, &pool);
+        else
+            ChunkLoader::readFile(chunk_x, chunk_z, result.chunk);
+        result.loaded = true;
+        result.saved = true;
+        complete(std::move(result));
+    };
+    if (isSaving(chunk_x, chunk_z))
+        requestWrite([this, load] { pool.submit(load); });
+    else
+        pool.submit(std::move(load));
+    return true;
+}
+
+/**
+ * @brief Generates a chunk to disk on a worker without loading it
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @return False if the chunk has already been requested
+ */
+bool ChunkStreamer::requestGenerate(int chunk_x, int chunk_z) {
+    if (in_flight.contains(chunk_x, chunk_z)) return false;
+    pool.submit([this, chunk_x, chunk_z, cancelled = track(chunk_x, chunk_z)] {
+        if (shutting_down) return;
+        Result result;
+        result.chunk = Chunk(chunk_x, chunk_z);
+        if (!*cancelled) {
+            if (!ChunkLoader::checkFile(chunk_x, chunk_z))
+                ChunkLoader::updateChunk(chunk_x, chunk_z);
+            result.saved = true;
+        }
+        complete(std::move(result));
+    });
+    return true;
+}
+
+/**
+ * @brief Queues a write on the ordered write lane
+ * @param write Function that writes to the save files
+ */
+void ChunkStreamer::requestWrite(std::function<void()> write) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    writes.push_back(std::move(write));
+    writes_requested++;
+    if (writing) return;
+    writing = true;
+    pool.submit([this] { drainWrites(); });
+}
+
+/**
+ * @brief Queues a copy of a chunk to replace what is saved for it
+ * @param chunk Chunk to save
+ */
+void ChunkStreamer::requestSave(const Chunk &chunk) {
+    requestWrite([chunk] { ChunkLoader::saveChunk(chunk); });
+    fence(chunk.getX(), chunk.getZ());
+}
+
+/**
+ * @brief Makes a later load of a chunk wait for every write requested so far
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ */
+void ChunkStreamer::fence(int chunk_x, int chunk_z) {
+    saves.insert(chunk_x, chunk_z, writes_requested);
+}
+
+/**
+ * @brief Runs queued writes in order until the lane is empty, only one worker runs this at a time
+ */
+void ChunkStreamer::drainWrites() {
+    std::unique_lock<std::mutex> lock(write_mutex);
+    while (!writes.empty()) {
+        std::function<void()> write = std::move(writes.front());
+        writes.pop_front();
+        lock.unlock();
+        write();
+        writes_done++;
+        lock.lock();
+    }
+    writing = false;
+}
+
+/**
+ * @brief Moves finished chunks into the world until the time budget is spent
+ * At least one chunk is integrated per call so streaming always makes progress.
+ *
+ * @param chunks Loaded chunks of the world
+ * @param budget_ms Time that may be spent, in milliseconds
+ * @return Number of chunks added to the world
+ */
+int ChunkStreamer::integrate(ChunkMap<Chunk> &chunks, double budget_ms) {
+    auto start = std::chrono::steady_clock::now();
+    int integrated = 0;
+    Result result;
+    while (completed.tryPop(result)) {
+        int chunk_x = result.chunk.getX();
+        int chunk_z = result.chunk.getZ();
+        in_flight.erase(chunk_x, chunk_z);
+        if (result.saved) saved_chunks.insert(chunk_x, chunk_z, true);
+        if (result.loaded && !chunks.contains(chunk_x, chunk_z)) {
+            chunks.insert(chunk_x, chunk_z, std::move(result.chunk));
+            integrated++;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budget_ms) break;
+    }
+    return integrated;
+}
+
+/**
+ * @brief Drops the chunks known to be saved that are further than a range from a chunk
+ * Keeps the set of saved chunks from growing without bound while the player explores. A forgotten chunk is only
+ * asked for again if the player comes back, and the worker then finds it on disk.
+ *
+ * @param center_x X position of the chunk the range is measured from
+ * @param center_z Z position of the chunk the range is measured from
+ * @param range Chunks at most this far away in either direction are kept
+ */
+void ChunkStreamer::forgetSaved(int center_x, int center_z, int range) {
+    std::vector<std::pair<int, int>> forgotten;
+    saved_chunks.forEach([&](int chunk_x, int chunk_z, bool) {
+        if (std::abs(chunk_x - center_x) > range || std::abs(chunk_z - center_z) > range)
+            forgotten.emplace_back(chunk_x, chunk_z);
+    });
+    for (const auto &[chunk_x, chunk_z] : forgotten) saved_chunks.erase(chunk_x, chunk_z);
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+// STL
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Utilities
+#include "utils/Histogram.hpp"
+
+/**
+ * @brief Percentiles of what every frame cost, over a rolling window of frames
+ * Each metric is recorded once per frame into a histogram of its own. Every LOG_INTERVAL the window is reported to
+ * the log file, if there is one, and started over, so the numbers always describe the last few seconds of play.
+ * Once the log reaches MAX_LOG_BYTES it is moved aside to a file ending in .old, so at most two logs are kept.
+ * Times are recorded in microseconds.
+ *
+ * Only the render thread records and reads the stats.
+ */
+class FrameStats {
+public:
+    enum Metric {
+        FRAME_TIME,       // Time between the starts of two frames
+        CPU_TIME,         // Time the frame spends before swapping buffers
+        STREAM_TIME,      // Scheduling, integrating and unloading chunks
+        MESH_TIME,        // Building and uploading chunk meshes
+        CULL_TIME,        // Occlusion search and frustum culling
+        DRAW_TIME,        // Issuing the chunk draws
+        INPUT_TIME,       // processInput
+        SWAP_TIME,        // glfwSwapBuffers, mostly waiting for the GPU and vsync
+        DRAW_CALLS,
+        TRIANGLES,
+        CHUNKS_DRAWN,     // Chunks in render distance that were at least partly inside the view frustum
+        CHUNKS_CULLED,    // Chunks in render distance that were outside the view frustum
+        CHUNKS_OCCLUDED,  // Chunks in render distance that the camera cannot see through air
+        RESIDENT_CHUNKS,  // Chunks held in memory
+        RESIDENT_BYTES,   // Block data of the chunks held in memory
+        CHUNKS_EVICTED,   // Chunks unloaded during the frame to stay inside the memory budget
+        BYTES_READ,       // Chunk data read from region files during the frame
+        BYTES_WRITTEN,    // Chunk data written to region files during the frame
+        QUEUE_DEPTH,      // Chunks waiting to be streamed in, queued or on a worker
+        CHUNKS_CANCELLED, // Chunks dropped from the streamer during the frame because they fell out of range
+        METRICS
+    };
+
+    constexpr static std::chrono::seconds LOG_INTERVAL{10};
+    constexpr static uintmax_t MAX_LOG_BYTES = 1 << 20; // About three hours of play at 1 KB per report
+
+    /**
+     * @brief Times a phase of the frame from its construction to the end of its scope
+     */
+    class Timer {
+    private:
+        FrameStats &stats;
+        Metric metric;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    public:
+        Timer(FrameStats &stats, Metric metric) : stats(stats), metric(metric) {}
+        ~Timer() { stats.record(metric, std::chrono::steady_clock::now() - start); }
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+    };
+
+private:
+    std::vector<Histogram> histograms = std::vector<Histogram>(METRICS); // About 30 KB each, so not on the stack
+    std::string log_path;
+    std::chrono::steady_clock::time_point window_start = std::chrono::steady_clock::now();
+
+public:
+    /**
+     * @param log_path File the report of every window is appended to, or empty to not log
+     */
+    explicit FrameStats(std::string log_path = "") : log_path(std::move(log_path)) {}
+
+    static const char *metricName(Metric metric);
+
+    void record(Metric metric, uint64_t value) { histograms[metric].record(value); }
+    void record(Metric metric, std::chrono::steady_clock::duration time) {
+        record(metric, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(time).count());
+    }
+
+    const Histogram &get(Metric metric) const { return histograms[metric]; }
+    uint64_t percentile(Metric metric, double percent) const { return histograms[metric].percentile(percent); }
+    uint64_t frames() const { return histograms[FRAME_TIME].count(); }
+
+    std::string report() const;
+    void endFrame();
+    void reset();
+};
+
+const char *FrameStats::metricName(Metric metric) {
+    static const char *names[METRICS] = {"frame ms", "cpu ms", "stream ms", "mesh ms", "cull ms", "draw ms", "input ms",
+                                         "swap ms", "draw calls", "triangles", "chunks drawn", "chunks culled",
+                                         "chunks occluded", "resident chunks", "resident bytes", "chunks evicted",
+                                         "bytes read", "bytes written", "queue depth", "chunks cancelled"};
+    return names[metric];
+}
+
+/**
+ * @brief Table of the p50, p95, p99 and max of every metric in the current window
+ */
+std::string FrameStats::report() const {
+    std::ostringstream out;
+    out << frames() << " frames" << std::endl;
+    out << std::left << std::setw(18) << "" << std::right;
+    for (const char *column : {"p50", "p95", "p99", "max"}) out << std::setw(12) << column;
+    out << std::endl;
+    for (int i = 0; i < METRICS; i++) {
+        Metric metric = (Metric)i;
+        const Histogram &histogram = histograms[metric];
+        // Times are kept in microseconds and shown in milliseconds
+        bool time = metric <= SWAP_TIME;
+        out << std::left << std::setw(18) << metricName(metric) << std::right << std::fixed
+            << std::setprecision(time ? 2 : 0);
+        for (uint64_t value : {histogram.percentile(50), histogram.percentile(95), histogram.percentile(99),
+                               histogram.max()}) {
+            out << std::setw(12) << (time ? (double)value / 1000.0 : (double)value);
+        }
+        out << std::endl;
+    }
+    return out.str();
+}
+
+/**
+ * @brief Ends the frame, and once the window has lasted LOG_INTERVAL appends its report to the log and starts over
+ */
+void FrameStats::endFrame() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - window_start < LOG_INTERVAL) return;
+    if (!log_path.empty()) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(log_path, error);
+        if (!error && size >= MAX_LOG_BYTES) std::filesystem::rename(log_path, log_path + ".old", error);
+        std::ofstream ofs(log_path, std::ios::app);
+        std::time_t time = std::time(nullptr);
+        ofs << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S") << ", " << report() << std::endl;
+    }
+    reset();
+}
+
+/**
+ * @brief Starts a new window without reporting the current one
+ */
+void FrameStats::reset() {
+    for (Histogram &histogram : histograms) histogram.reset();
+    window_start = std::chrono::steady_clock::now();
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+// Dependencies
+#include "glm/glm.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Axis aligned boxes stored one coordinate per array, so a test over every box reads each array in order
+ */
+struct BoxBatch {
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+
+    size_t size() const { return min_x.size(); }
+
+    void clear() {
+        min_x.clear(), min_y.clear(), min_z.clear();
+        max_x.clear(), max_y.clear(), max_z.clear();
+    }
+
+    void add(glm::vec3 min, glm::vec3 max) {
+        min_x.push_back(min.x), min_y.push_back(min.y), min_z.push_back(min.z);
+        max_x.push_back(max.x), max_y.push_back(max.y), max_z.push_back(max.z);
+    }
+};
+
+/**
+ * @brief The six planes around what the camera can see
+ * Planes are taken straight from the projection * view matrix, so anything the matrix would clip is outside.
+ * A box is outside when it is completely behind one of the planes. Boxes that cross a corner of the frustum without
+ * touching it are kept, which only costs a draw that the GPU clips away.
+ */
+class Frustum {
+private:
+    // Plane i keeps the points where a[i] * x + b[i] * y + c[i] * z + d[i] >= 0
+    float a[6], b[6], c[6], d[6];
+
+public:
+    explicit Frustum(const glm::mat4 &clip);
+
+    bool intersects(glm::vec3 min, glm::vec3 max) const;
+    size_t cull(const BoxBatch &boxes, std::vector<uint8_t> &visible) const;
+};
+
+/**
+ * @param clip projection * view matrix
+ */
+Frustum::Frustum(const glm::mat4 &clip) {
+    // Left, right, bottom, top, near and far are the fourth row plus or minus one of the other rows.
+    for (int i = 0; i < 6; i++) {
+        int row = i / 2;
+        float sign = i % 2 == 0 ? 1.0f : -1.0f;
+        a[i] = clip[0][3] + sign * clip[0][row];
+        b[i] = clip[1][3] + sign * clip[1][row];
+        c[i] = clip[2][3] + sign * clip[2][row];
+        d[i] = clip[3][3] + sign * clip[3][row];
+    }
+}
+
+/**
+ * @brief Tests one box
+ * @return False if the box is completely outside
+ */
+bool Frustum::intersects(glm::vec3 min, glm::vec3 max) const {
+    for (int i = 0; i < 6; i++) {
+        // Corner of the box furthest along the plane normal
+        float x = a[i] >= 0 ? max.x : min.x;
+        float y = b[i] >= 0 ? max.y : min.y;
+        float z = c[i] >= 0 ? max.z : min.z;
+        if (a[i] * x + b[i] * y + c[i] * z + d[i] < 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Tests every box of a batch
+ * Each plane picks which corner to test once for the whole batch, so the inner loop is the same multiply and add
+ * for every box and the compiler can vectorize it.
+ *
+ * @param boxes Boxes to test
+ * @param visible Set to 1 for every box that is at least partly inside and 0 for the rest
+ * @return Number of boxes that are at least partly inside
+ */
+size_t Frustum::cull(const BoxBatch &boxes, std::vector<uint8_t> &visible) const {
+    size_t count = boxes.size();
+    visible.assign(count, 1);
+    uint8_t *out = visible.data();
+    for (int i = 0; i < 6; i++) {
+        const float *xs = a[i] >= 0 ? boxes.max_x.data() : boxes.min_x.data();
+        const float *ys = b[i] >= 0 ? boxes.max_y.data() : boxes.min_y.data();
+        const float *zs = c[i] >= 0 ? boxes.max_z.data() : boxes.min_z.data();
+        float pa = a[i], pb = b[i], pc = c[i], pd = d[i];
+        for (size_t j = 0; j < count; j++) out[j] &= (uint8_t)(pa * xs[j] + pb * ys[j] + pc * zs[j] + pd >= 0);
+    }
+
+    size_t inside = 0;
+    for (size_t j = 0; j < count; j++) inside += out[j];
+    return inside;
+}
+
+#endif
@@ -10,7 +10,11 @@ enum {
     HAPPY_FACE,
     BEDROCK,
     GRASS,
-    WATER
+    WATER,
+    STONE,
+    DIRT,
+    SAND,
+    BLOCK_TYPES // Number of block types, keep it last
 };
 
 class Inventory {
@@ -26,6 +30,9 @@ public:
         blocks.insert({BEDROCK, start_num});
         blocks.insert({GRASS, start_num});
         blocks.insert({WATER, start_num});
+        blocks.insert({STONE, start_num});
+        blocks.insert({DIRT, start_num});
+        blocks.insert({SAND, start_num});
     }
 
     int getBlockCount(int type) {
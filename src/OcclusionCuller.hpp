@@ -0,0 +1,173 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+// Dependencies
+#include "glm/glm.hpp"
+
+// STL
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+// Header Files
+#include "Chunk.hpp"
+#include "ChunkLoader.hpp"
+#include "ChunkMap.hpp"
+
+/**
+ * @brief Finds the chunks the camera could see through air, without asking the GPU
+ * Every section records which of its six faces are joined by air inside it. Each frame a breadth first search walks
+ * from the section the camera is in to its neighbours, leaving a section only through a face that is joined to the
+ * face it came in by, and never turning back towards the camera. Chunks the search never reaches are hidden behind
+ * solid ground, like the caves under the player when standing on the surface.
+ *
+ * The walk only looks at air, so it never hides a chunk that could be seen but can keep some that cannot.
+ */
+class OcclusionCuller {
+public:
+    // Faces of a section, opposite faces differ in the lowest bit
+    enum Face { NEG_X, POS_X, NEG_Y, POS_Y, NEG_Z, POS_Z, FACES };
+
+    // Bit a * 8 + b is set when faces a and b are joined by air
+    using SectionFaces = uint64_t;
+    constexpr static SectionFaces ALL_FACES = 0x3F3F3F3F3F3FULL;
+
+private:
+    ChunkMap<std::array<SectionFaces, Chunk::SECTIONS>> chunks;
+    ChunkMap<uint8_t> reached; // Bit per section that the last search reached
+    bool searched = false;     // False when the last search could not start and every chunk counts as seen
+
+    struct Step {
+        int chunk_x, section, chunk_z;
+        int entered;    // Face the search came in by, FACES for the camera's section
+        int directions; // Bit per face the search has moved towards so far
+    };
+
+    static bool joined(SectionFaces faces, int a, int b) {
+        return (faces >> (a * 8 + b)) & 1;
+    }
+
+public:
+    static SectionFaces findJoinedFaces(const ChunkSection &section);
+
+    void update(const Chunk &chunk);
+    void remove(int chunk_x, int chunk_z) { chunks.erase(chunk_x, chunk_z); }
+
+    void search(glm::vec3 position, int render_distance);
+    bool isVisible(int chunk_x, int chunk_z) const;
+};
+
+/**
+ * @brief Flood fills the air of a section and records which faces each pocket of air touches
+ * @return Pairs of faces that are joined by air
+ */
+OcclusionCuller::SectionFaces OcclusionCuller::findJoinedFaces(const ChunkSection &section) {
+    constexpr int SIZE = ChunkSection::SIZE;
+    if (section.empty()) return ALL_FACES;
+    if (section.getBlockCount() == ChunkSection::VOLUME) return 0;
+
+    auto index = [](int x, int y, int z) { return (y * SIZE + z) * SIZE + x; };
+    std::vector<uint8_t> closed(ChunkSection::VOLUME, 0); // Blocks, and air that has been filled already
+    section.forEachBlock([&](int x, int y, int z, int) { closed[index(x, y, z)] = 1; });
+
+    SectionFaces faces = 0;
+    std::vector<int> stack;
+    stack.reserve(ChunkSection::VOLUME);
+    for (int start = 0; start < ChunkSection::VOLUME; start++) {
+        if (closed[start]) continue;
+        closed[start] = 1;
+        stack.push_back(start);
+        int touched = 0;
+        while (!stack.empty()) {
+            int i = stack.back();
+            stack.pop_back();
+            int x = i % SIZE, y = i / (SIZE * SIZE), z = (i / SIZE) % SIZE;
+            touched |= (x == 0) << NEG_X | (x == SIZE - 1) << POS_X | (y == 0) << NEG_Y | (y == SIZE - 1) << POS_Y |
+                       (z == 0) << NEG_Z | (z == SIZE - 1) << POS_Z;
+            auto visit = [&](int nx, int ny, int nz) {
+                int n = index(nx, ny, nz);
+                if (closed[n]) return;
+                closed[n] = 1;
+                stack.push_back(n);
+            };
+            if (x > 0) visit(x - 1, y, z);
+            if (x < SIZE - 1) visit(x + 1, y, z);
+            if (y > 0) visit(x, y - 1, z);
+            if (y < SIZE - 1) visit(x, y + 1, z);
+            if (z > 0) visit(x, y, z - 1);
+            if (z < SIZE - 1) visit(x, y, z + 1);
+        }
+        for (int a = 0; a < FACES; a++) {
+            if (touched >> a & 1) faces |= (SectionFaces)touched << (a * 8);
+        }
+    }
+    return faces;
+}
+
+/**
+ * @brief Records which faces of every section of a chunk are joined, call it whenever the chunk changes
+ */
+void OcclusionCuller::update(const Chunk &chunk) {
+    std::array<SectionFaces, Chunk::SECTIONS> faces;
+    for (int s = 0; s < Chunk::SECTIONS; s++) faces[s] = findJoinedFaces(chunk.getSection(s));
+    chunks.insert(chunk.getX(), chunk.getZ(), faces);
+}
+
+/**
+ * @brief Walks through the air around the camera to find the chunks it could see
+ * @param position Camera position
+ * @param render_distance Chunks further away are not walked through
+ */
+void OcclusionCuller::search(glm::vec3 position, int render_distance) {
+    reached.clear();
+    int center_x = ChunkLoader::chunkCoord((int)std::floor(position.x));
+    int center_z = ChunkLoader::chunkCoord((int)std::floor(position.z));
+    int center_section = std::max(0, std::min(Chunk::SECTIONS - 1, (int)std::floor(position.y) / ChunkSection::SIZE));
+    searched = chunks.contains(center_x, center_z);
+    if (!searched) return;
+
+    const int step_x[FACES] = {-1, 1, 0, 0, 0, 0};
+    const int step_y[FACES] = {0, 0, -1, 1, 0, 0};
+    const int step_z[FACES] = {0, 0, 0, 0, -1, 1};
+
+    std::deque<Step> queue;
+    queue.push_back({center_x, center_section, center_z, FACES, 0});
+    reached.insert(center_x, center_z, (uint8_t)(1 << center_section));
+    while (!queue.empty()) {
+        Step step = queue.front();
+        queue.pop_front();
+        SectionFaces faces = (*chunks.find(step.chunk_x, step.chunk_z))[step.section];
+        for (int face = 0; face < FACES; face++) {
+            // Turning back towards the camera can only reach sections that are already behind another route
+            if (step.directions >> (face ^ 1) & 1) continue;
+            if (step.entered != FACES && !joined(faces, step.entered, face)) continue;
+
+            int chunk_x = step.chunk_x + step_x[face];
+            int section = step.section + step_y[face];
+            int chunk_z = step.chunk_z + step_z[face];
+            if (section < 0 || section >= Chunk::SECTIONS) continue;
+            if (std::abs(chunk_x - center_x) > render_distance || std::abs(chunk_z - center_z) > render_distance) continue;
+            if (!chunks.contains(chunk_x, chunk_z)) continue;
+
+            uint8_t *sections = reached.find(chunk_x, chunk_z);
+            if (sections == nullptr) sections = &reached.insert(chunk_x, chunk_z, 0);
+            if (*sections >> section & 1) continue;
+            *sections |= (uint8_t)(1 << section);
+            queue.push_back({chunk_x, section, chunk_z, face ^ 1, step.directions | 1 << face});
+        }
+    }
+}
+
+/**
+ * @brief Checks whether the last search reached any section of a chunk
+ * Every chunk counts as visible if the search could not start because the camera's chunk is not loaded.
+ */
+bool OcclusionCuller::isVisible(int chunk_x, int chunk_z) const {
+    return !searched || reached.contains(chunk_x, chunk_z);
+}
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef REGIONFILE_H
+#define REGIONFILE_H
+
+// STL
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A region holds REGION_SIZE x REGION_SIZE chunks in a single file.
+constexpr int REGION_SIZE = 32;
+constexpr int REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+
+// Where a chunk payload lives inside its region file.
+struct RegionEntry {
+    uint32_t offset;   // Byte offset of the payload, 0 if the chunk has never been written
+    uint32_t length;   // Bytes of the payload currently in use
+    uint32_t capacity; // Bytes reserved for the payload so it can grow in place
+    uint32_t reserved;
+};
+
+/**
+ * @brief Container file for a square of chunks
+ * The file starts with a small header and a table of REGION_CHUNKS entries that give the offset, length and
+ * capacity of every chunk payload. The table is kept in memory, so checking whether a chunk exists is a table
+ * lookup and reading or writing a chunk is a single seek plus a single read or write.
+ *
+ * Region file layout:
+ *     MAGIC(4) | VERSION(4) | RegionEntry[REGION_CHUNKS] | payloads...
+ */
+class RegionFile {
+private:
+    constexpr static char MAGIC[4] = {'B', 'B', 'R', 'G'};
+    constexpr static uint32_t VERSION = 1;
+    constexpr static uint32_t SECTOR_SIZE = 1024;
+    constexpr static uint32_t TABLE_OFFSET = sizeof(MAGIC) + sizeof(VERSION);
+    constexpr static uint32_t DATA_OFFSET = TABLE_OFFSET + sizeof(RegionEntry) * REGION_CHUNKS;
+
+    struct Extent {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::string path;
+    std::fstream stream;
+    std::array<RegionEntry, REGION_CHUNKS> directory{};
+    std::vector<Extent> free_extents; // Space left behind by payloads that outgrew their slot
+    uint32_t file_end = DATA_OFFSET;
+    bool unusable = false; // The file exists but could not be read, so it is never written over
+
+    static int index(int local_x, int local_z) { return local_z * REGION_SIZE + local_x; }
+    bool create();
+    bool writeEntry(int slot);
+    uint32_t allocate(uint32_t size);
+    void release(uint32_t offset, uint32_t size);
+
+public:
+    explicit RegionFile(std::string path);
+    RegionFile(const RegionFile &) = delete;
+    RegionFile &operator=(const RegionFile &) = delete;
+
+    bool hasChunk(int local_x, int local_z) const;
+    bool readChunk(int local_x, int local_z, std::vector<char> &payload);
+    bool writeChunk(int local_x, int local_z, const char *data, uint32_t size);
+    bool appendChunk(int local_x, int local_z, const char *data, uint32_t size);
+    const std::string &getPath() const { return path; }
+    bool isUsable() const { return !unusable; }
+
+    static std::string findFile(int region_x, int region_z);
+};
+
+/**
+ * @brief Opens a region file and loads its chunk table into memory
+ * Nothing is created on disk until the first write, so probing regions that were never generated is free. A file
+ * that cannot be opened, is too short, or has the wrong magic or version (like a region of a newer game) is left
+ * exactly as it is: the region holds no chunks and refuses every write, instead of creating a new file over it.
+ *
+ * @param path Path of the region file
+ */
+RegionFile::RegionFile(std::string path) : path(std::move(path)) {
+    if (!std::filesystem::exists(this->path)) return;
+
+    stream.open(this->path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!stream.is_open()) {
+        std::cerr << "Cannot Open Region: " << this->path << std::endl;
+        unusable = true;
+        return;
+    }
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    stream.read(magic, sizeof(magic));
+    stream.read((char *)&version, sizeof(version));
+    stream.read((char *)directory.data(), sizeof(RegionEntry) * REGION_CHUNKS);
+    if (!stream || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION) {
+        std::cerr << "Corrupt Region, leaving it untouched: " << this->path << std::endl;
+        directory.fill(RegionEntry{});
+        stream.close();
+        unusable = true;
+        return;
+    }
+
+    // Rebuild the free list from the gaps between payloads.
+    std::vector<Extent> used;
+    for (const RegionEntry &entry : directory) {
+        if (entry.offset != 0) used.push_back({entry.offset, entry.capacity});
+    }
+    std::sort(used.begin(), used.end(), [](const Extent &a, const Extent &b) { return a.offset < b.offset; });
+    file_end = DATA_OFFSET;
+    for (const Extent &extent : used) {
+        if (extent.offset > file_end) free_extents.push_back({file_end, extent.offset - file_end});
+        file_end = std::max(file_end, extent.offset + extent.size);
+    }
+}
+
+/**
+ * @brief Creates the region file with an empty chunk table
+ * @return True if the file is open for writing, false if it could not be created or is unusable
+ */
+bool RegionFile::create() {
+    if (stream.is_open()) return true;
+    if (unusable) return false;
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(MAGIC, sizeof(MAGIC));
+    ofs.write((const char *)&VERSION, sizeof(VERSION));
+    ofs.write((const char *)directory.data(), sizeof(RegionEntry) * REGION_CHUNKS);
+    ofs.close();
+    stream.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!stream.is_open()) {
+        std::cerr << "Save file not open! " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes one chunk table entry back to disk
+ * @param slot Index of the entry in the table
+ */
+bool RegionFile::writeEntry(int slot) {
+    stream.seekp(TABLE_OFFSET + slot * sizeof(RegionEntry));
+    stream.write((const char *)&directory[slot], sizeof(RegionEntry));
+    stream.flush();
+    if (!stream.good()) {
+        stream.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reserves space for a payload, reusing freed space when a big enough gap exists
+ * @param size Bytes needed, already rounded to a whole number of sectors
+ * @return Offset of the reserved space
+ */
+uint32_t RegionFile::allocate(uint32_t size) {
+    for (auto itr = free_extents.begin(); itr != free_extents.end(); itr++) {
+        if (itr->size < size) continue;
+        uint32_t offset = itr->offset;
+        itr->offset += size;
+        itr->size -= size;
+        if (itr->size == 0) free_extents.erase(itr);
+        return offset;
+    }
+    uint32_t offset = file_end;
+    file_end += size;
+    return offset;
+}
+
+/**
+ * @brief Returns space that is no longer used by any payload to the free list
+ * The free list is kept sorted by offset and gaps that touch are merged, so space freed by chunks that keep growing
+ * can be reused by bigger payloads. A gap that reaches the end of the file shrinks the file instead.
+ */
+void RegionFile::release(uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    auto itr = std::lower_bound(free_extents.begin(), free_extents.end(), offset,
+                                [](const Extent &extent, uint32_t value) { return extent.offset < value; });
+    itr = free_extents.insert(itr, {offset, size});
+    if (itr + 1 != free_extents.end() && itr->offset + itr->size == (itr + 1)->offset) {
+        itr->size += (itr + 1)->size;
+        free_extents.erase(itr + 1);
+    }
+    if (itr != free_extents.begin() && (itr - 1)->offset + (itr - 1)->size == itr->offset) {
+        (itr - 1)->size += itr->size;
+        itr = free_extents.erase(itr) - 1;
+    }
+    if (itr->offset + itr->size == file_end) {
+        file_end = itr->offset;
+        free_extents.erase(itr);
+    }
+}
+
+/**
+ * @brief Checks the in-memory table to see if a chunk has been written
+ * @param local_x X position of the chunk inside the region
+ * @param local_z Z position of the chunk inside the region
+ */
+bool RegionFile::hasChunk(int local_x, int local_z) const {
+    return directory[index(local_x, local_z)].offset != 0;
+}
+
+/**
+ * @brief Reads a whole chunk payload with a single read
+ * @param local_x X position of the chunk inside the region
+ * @param local_z Z position of the chunk inside the region
+ * @param payload Receives the payload bytes
+ * @return False if the chunk does not exist or could not be read
+ */
+bool RegionFile::readChunk(int local_x, int local_z, std::vector<char> &payload) {
+    const RegionEntry &entry = directory[index(local_x, local_z)];
+    payload.clear();
+    if (entry.offset == 0 || !stream.is_open()) return false;
+
+    payload.resize(entry.length);
+    stream.seekg(entry.offset);
+    stream.read(payload.data(), entry.length);
+    if (!stream) {
+        std::cerr << "Failed to read the chunk from " << path << std::endl;
+        stream.clear();
+        payload.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Replaces a whole chunk payload
+ * The payload is overwritten in place when it fits its slot, otherwise it is moved to a bigger slot. The old slot is
+ * only freed once the table entry pointing at the new one is on disk, so a failed write never leaves the table
+ * pointing at space that has been handed to another chunk.
+ *
+ * @param local_x X position of the chunk inside the region
+ * @param local_z Z position of the chunk inside the region
+ * @param data Payload bytes
+ * @param size Number of payload bytes
+ */
+bool RegionFile::writeChunk(int local_x, int local_z, const char *data, uint32_t size) {
+    if (!create()) return false;
+    int slot = index(local_x, local_z);
+    RegionEntry previous = directory[slot];
+    RegionEntry entry = previous;
+
+    bool moved = entry.offset == 0 || size > entry.capacity;
+    if (moved) {
+        entry.capacity = std::max(SECTOR_SIZE, (size + size / 2 + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE);
+        entry.offset = allocate(entry.capacity);
+    }
+    entry.length = size;
+
+    stream.seekp(entry.offset);
+    stream.write(data, size);
+    if (!stream.good()) {
+        std::cerr << "Error occurred at writing time!" << std::endl;
+        stream.clear();
+        if (moved) release(entry.offset, entry.capacity);
+        return false;
+    }
+    directory[slot] = entry;
+    if (!writeEntry(slot)) {
+        std::cerr << "Error occurred at writing time!" << std::endl;
+        directory[slot] = previous;
+        if (moved) release(entry.offset, entry.capacity);
+        return false;
+    }
+    if (moved) release(previous.offset, previous.capacity);
+    return true;
+}
+
+/**
+ * @brief Adds bytes to the end of a chunk payload
+ * Appending only touches the new bytes and the table entry unless the payload has outgrown its slot.
+ *
+ * @param local_x X position of the chunk inside the region
+ * @param local_z Z position of the chunk inside the region
+ * @param data Bytes to append
+ * @param size Number of bytes to append
+ */
+bool RegionFile::appendChunk(int local_x, int local_z, const char *data, uint32_t size) {
+    int slot = index(local_x, local_z);
+    RegionEntry &entry = directory[slot];
+    if (entry.offset == 0) return writeChunk(local_x, local_z, data, size);
+
+    if (entry.length + size > entry.capacity) {
+        std::vector<char> payload;
+        readChunk(local_x, local_z, payload);
+        payload.insert(payload.end(), data, data + size);
+        return writeChunk(local_x, local_z, payload.data(), payload.size());
+    }
+
+    stream.seekp(entry.offset + entry.length);
+    stream.write(data, size);
+    if (!stream.good()) {
+        std::cerr << "Error occurred at writing time!" << std::endl;
+        stream.clear();
+        return false;
+    }
+    entry.length += size;
+    if (!writeEntry(slot)) {
+        std::cerr << "Error occurred at writing time!" << std::endl;
+        entry.length -= size;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Converts region coordinates into the region file name
+ * @param region_x X position of the region
+ * @param region_z Z position of the region
+ * @return File name
+ */
+std::string RegionFile::findFile(int region_x, int region_z) {
+    std::string file = "Region(";
+    file.append(std::to_string(region_x));
+    file.append(",");
+    file.append(std::to_string(region_z));
+    file.append(").bin");
+    return file;
+}
+
+#endif
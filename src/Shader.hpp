@@ -14,9 +14,45 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/// <summary>
+/// Location of a uniform in a shader program, typed by the value the uniform holds so it can only be set with the
+/// matching setter. A location of -1 means the uniform is not in the program and setting it does nothing.
+/// </summary>
+template<class T>
+struct Uniform {
+    int location = -1;
+};
 
 class Shader {
+private:
+    // Location of every active uniform, filled once after linking
+    std::unordered_map<std::string, int> uniform_locations;
+
+    /// <summary>
+    /// Asks the driver for every active uniform once so lookups never go back to it
+    /// </summary>
+    void loadUniformLocations() {
+        int count = 0, max_length = 0;
+        glGetProgramiv(ProgramID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ProgramID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+        std::string name(max_length, '\0');
+        for (int i = 0; i < count; i++) {
+            int length = 0, size = 0;
+            unsigned int type = 0;
+            glGetActiveUniform(ProgramID, i, max_length, &length, &size, &type, name.data());
+            std::string uniform_name = name.substr(0, length);
+            int location = glGetUniformLocation(ProgramID, uniform_name.c_str());
+            uniform_locations[uniform_name] = location;
+            // Arrays are reported as "name[0]" but are usually set by their plain name
+            if (uniform_name.size() > 3 && uniform_name.compare(uniform_name.size() - 3, 3, "[0]") == 0)
+                uniform_locations[uniform_name.substr(0, uniform_name.size() - 3)] = location;
+        }
+    }
+
 public:
     unsigned int ProgramID;
 
@@ -101,23 +137,65 @@ public:
         }
         glDeleteShader(vertex_shader);
         glDeleteShader(fragment_shader);
+        loadUniformLocations();
     }
 
     void use() {
         glUseProgram(ProgramID);
     }
 
-    // uniform setter functions
+    /// <summary>
+    /// Location of a uniform from the table built at link time
+    /// </summary>
+    /// <returns>The location, or -1 if the program has no active uniform with that name</returns>
+    int getLocation(const std::string &name) const {
+        auto it = uniform_locations.find(name);
+        return it == uniform_locations.end() ? -1 : it->second;
+    }
+
+    /// <summary>
+    /// Typed handle to a uniform, look it up once and keep it for hot loops
+    /// </summary>
+    template<class T>
+    Uniform<T> uniform(const std::string &name) const {
+        return Uniform<T>{getLocation(name)};
+    }
+
+    // uniform setter functions, the shader must be in use
+    void set(Uniform<bool> uniform, bool value) const {
+        glUniform1i(uniform.location, (int)value);
+    }
+
+    void set(Uniform<int> uniform, int value) const {
+        glUniform1i(uniform.location, value);
+    }
+
+    void set(Uniform<float> uniform, float value) const {
+        glUniform1f(uniform.location, value);
+    }
+
+    void set(Uniform<glm::vec4> uniform, const glm::vec4 &value) const {
+        glUniform4fv(uniform.location, 1, glm::value_ptr(value));
+    }
+
+    void set(Uniform<glm::mat4> uniform, const glm::mat4 &value) const {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
     void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(ProgramID, name.c_str()), (int)value);
+        set(uniform<bool>(name), value);
     }
 
     void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(ProgramID, name.c_str()), value);
+        set(uniform<int>(name), value);
     }
 
     void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(ProgramID, name.c_str()), value);
+        set(uniform<float>(name), value);
+    }
+
+    void setMat4(const std::string &name, const glm::mat4 &value) const {
+        set(uniform<glm::mat4>(name), value);
     }
 
     int getId() {
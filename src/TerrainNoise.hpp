@@ -0,0 +1,333 @@
+#ifndef TERRAINNOISE_H
+#define TERRAINNOISE_H
+
+// STL
+#include <cmath>
+#include <cstdint>
+
+// Header Files
+#include "PerlinNoise.hpp"
+
+// The vector kernels need x86 intrinsics and a compiler that can build a function for a CPU feature on its own.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TERRAIN_NOISE_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Seeded noise that the terrain is built from
+ * The seed shuffles the permutation table of the noise once, and every lookup after that only reads the table, so a
+ * sample depends on nothing but the seed and the position. The shuffle uses the noise's own Fisher-Yates over
+ * std::mt19937 instead of std::shuffle, so a seed makes the same world with every standard library.
+ *
+ * Lookups are const and can run on any number of threads at once.
+ */
+class TerrainNoise {
+public:
+    using Seed = siv::BasicPerlinNoise<float>::seed_type;
+
+    // Ways of sampling a grid of columns, every kernel gives exactly the same values
+    enum class Kernel { SCALAR, SSE41, AVX2 };
+
+private:
+    Seed seed = 0;
+    siv::BasicPerlinNoise<float> noise{0};
+    int32_t permutation[256]; // Permutation of the noise widened to ints for the vector kernels
+
+    // The noise is 3D noise sampled on a plane, these are the parts of a lookup that only depend on that plane
+    float plane_z = 0;
+    int32_t plane_iz = 0;
+    float plane_fade = 0;
+
+    void loadTables();
+    static float fade(float t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+
+#ifdef TERRAIN_NOISE_SIMD
+    void sampleSSE41(int start_x, int start_z, int width, int depth, float frequency, float *values) const;
+    void sampleAVX2(int start_x, int start_z, int width, int depth, float frequency, float *values) const;
+#endif
+
+public:
+    TerrainNoise() { loadTables(); }
+    explicit TerrainNoise(Seed seed) : seed(seed), noise(seed) { loadTables(); }
+
+    Seed getSeed() const { return seed; }
+
+    float sample(int x, int z, float frequency) const;
+    float sample(int x, int y, int z, float frequency, int octaves) const;
+    void sample(int start_x, int start_z, int width, int depth, float frequency, float *values) const;
+    void sample(int start_x, int start_z, int width, int depth, float frequency, float *values, Kernel kernel) const;
+
+    static Kernel bestKernel();
+    static bool isSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+};
+
+/**
+ * @brief Copies the permutation of the noise into the tables the vector kernels read
+ */
+void TerrainNoise::loadTables() {
+    const auto &state = noise.serialize();
+    for (int i = 0; i < 256; i++) permutation[i] = state[i];
+
+    // Same steps as the noise takes for its third coordinate, so the kernels round the same way
+    plane_z = static_cast<float>(SIVPERLIN_DEFAULT_Z);
+    float floor_z = std::floor(plane_z);
+    plane_iz = static_cast<int32_t>(floor_z) & 255;
+    plane_z -= floor_z;
+    plane_fade = fade(plane_z);
+}
+
+/**
+ * @brief Noise at one column
+ * @param x X position of the column
+ * @param z Z position of the column
+ * @param frequency Noise cells per block
+ * @return Noise roughly in the range -1 to 1
+ */
+float TerrainNoise::sample(int x, int z, float frequency) const {
+    return noise.noise2D((float)x * frequency, (float)z * frequency);
+}
+
+/**
+ * @brief Fractal 3D noise at one block, for shapes the heightmap cannot make like caves and overhangs
+ * @param x X position of the block
+ * @param y Y position of the block
+ * @param z Z position of the block
+ * @param frequency Noise cells per block of the first octave
+ * @param octaves Octaves to add up, each at double the frequency and half the amplitude of the last
+ * @return Noise roughly in the range -1 to 1
+ */
+float TerrainNoise::sample(int x, int y, int z, float frequency, int octaves) const {
+    return noise.normalizedOctave3D((float)x * frequency, (float)y * frequency, (float)z * frequency, octaves);
+}
+
+/**
+ * @brief Samples a grid of columns with the fastest kernel the CPU supports
+ * @param start_x X position of the first column
+ * @param start_z Z position of the first column
+ * @param width Columns along X
+ * @param depth Columns along Z
+ * @param frequency Noise cells per block
+ * @param values Filled with width * depth samples, the column at (x, z) is at index (z - start_z) * width + x - start_x
+ */
+void TerrainNoise::sample(int start_x, int start_z, int width, int depth, float frequency, float *values) const {
+    static const Kernel best = bestKernel();
+    sample(start_x, start_z, width, depth, frequency, values, best);
+}
+
+/**
+ * @brief Samples a grid of columns with a chosen kernel, falling back to the scalar one if the CPU does not support it
+ */
+void TerrainNoise::sample(int start_x, int start_z, int width, int depth, float frequency, float *values,
+                          Kernel kernel) const {
+#ifdef TERRAIN_NOISE_SIMD
+    if (kernel == Kernel::AVX2 && isSupported(kernel))
+        return sampleAVX2(start_x, start_z, width, depth, frequency, values);
+    if (kernel == Kernel::SSE41 && isSupported(kernel))
+        return sampleSSE41(start_x, start_z, width, depth, frequency, values);
+#endif
+    for (int z = 0; z < depth; z++) {
+        for (int x = 0; x < width; x++) values[z * width + x] = sample(start_x + x, start_z + z, frequency);
+    }
+}
+
+/**
+ * @brief Fastest kernel the CPU supports
+ */
+TerrainNoise::Kernel TerrainNoise::bestKernel() {
+    if (isSupported(Kernel::AVX2)) return Kernel::AVX2;
+    if (isSupported(Kernel::SSE41)) return Kernel::SSE41;
+    return Kernel::SCALAR;
+}
+
+/**
+ * @brief Checks whether the CPU running the game can use a kernel
+ */
+bool TerrainNoise::isSupported(Kernel kernel) {
+    switch (kernel) {
+#ifdef TERRAIN_NOISE_SIMD
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Kernel::SSE41:
+            return __builtin_cpu_supports("sse4.1");
+#endif
+        case Kernel::SCALAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char *TerrainNoise::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AVX2:
+            return "avx2";
+        case Kernel::SSE41:
+            return "sse4.1";
+        default:
+            return "scalar";
+    }
+}
+
+#ifdef TERRAIN_NOISE_SIMD
+/*
+ * The kernels below run the steps of siv::BasicPerlinNoise::noise3D on one lane per column, in the same order and
+ * in float, so every lane rounds exactly like the scalar lookup. They are built without FMA on purpose since a fused
+ * multiply add rounds differently from a multiply followed by an add. Columns left over at the end of a row go
+ * through the scalar lookup.
+ *
+ * Lambdas do not take the target of the function around them, so the steps are free functions.
+ */
+namespace terrain_simd {
+    __attribute__((target("sse4.1"))) inline __m128i gather(const int32_t *table, __m128i index) {
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128((__m128i *)lanes, index);
+        return _mm_setr_epi32(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+    }
+
+    // Entry of the table after the one at index, wrapping at 256
+    __attribute__((target("sse4.1"))) inline __m128i gatherNext(const int32_t *table, __m128i index) {
+        return gather(table, _mm_and_si128(_mm_add_epi32(index, _mm_set1_epi32(1)), _mm_set1_epi32(255)));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128 fade(__m128 t) {
+        __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(15))), _mm_set1_ps(10));
+        return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128 lerp(__m128 a, __m128 b, __m128 t) {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128 grad(__m128i hash, __m128 x, __m128 y, __m128 z) {
+        __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+        __m128 u = _mm_blendv_ps(y, x, _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8))));
+        __m128i x_for_v = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+        __m128 v = _mm_blendv_ps(z, x, _mm_castsi128_ps(x_for_v));
+        v = _mm_blendv_ps(v, y, _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4))));
+        // Negating flips the sign bit, so flipping it directly gives the same bits
+        u = _mm_xor_ps(u, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31)));
+        v = _mm_xor_ps(v, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30)));
+        return _mm_add_ps(u, v);
+    }
+
+    __attribute__((target("avx2"))) inline __m256i gather(const int32_t *table, __m256i index) {
+        return _mm256_i32gather_epi32(table, index, 4);
+    }
+
+    __attribute__((target("avx2"))) inline __m256i gatherNext(const int32_t *table, __m256i index) {
+        return gather(table, _mm256_and_si256(_mm256_add_epi32(index, _mm256_set1_epi32(1)), _mm256_set1_epi32(255)));
+    }
+
+    __attribute__((target("avx2"))) inline __m256 fade(__m256 t) {
+        __m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6)), _mm256_set1_ps(15))), _mm256_set1_ps(10));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+    }
+
+    __attribute__((target("avx2"))) inline __m256 lerp(__m256 a, __m256 b, __m256 t) {
+        return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+    }
+
+    __attribute__((target("avx2"))) inline __m256 grad(__m256i hash, __m256 x, __m256 y, __m256 z) {
+        __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+        __m256 u = _mm256_blendv_ps(y, x, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h)));
+        __m256i x_for_v = _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14)));
+        __m256 v = _mm256_blendv_ps(z, x, _mm256_castsi256_ps(x_for_v));
+        v = _mm256_blendv_ps(v, y, _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h)));
+        u = _mm256_xor_ps(u, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31)));
+        v = _mm256_xor_ps(v, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30)));
+        return _mm256_add_ps(u, v);
+    }
+}
+
+/**
+ * @brief Samples a grid four columns at a time with SSE4.1
+ */
+__attribute__((target("sse4.1")))
+void TerrainNoise::sampleSSE41(int start_x, int start_z, int width, int depth, float frequency, float *values) const {
+    using namespace terrain_simd;
+    const int32_t *p = permutation;
+    const __m128i byte = _mm_set1_epi32(255);
+    const __m128i iz = _mm_set1_epi32(plane_iz);
+    const __m128 fz = _mm_set1_ps(plane_z), fz1 = _mm_set1_ps(plane_z - 1), w = _mm_set1_ps(plane_fade);
+    for (int row = 0; row < depth; row++) {
+        float y = (float)(start_z + row) * frequency;
+        float floor_y = std::floor(y);
+        __m128i iy = _mm_set1_epi32(static_cast<int32_t>(floor_y) & 255);
+        __m128 fy = _mm_set1_ps(y - floor_y), fy1 = _mm_set1_ps(y - floor_y - 1);
+        __m128 v = _mm_set1_ps(fade(y - floor_y));
+
+        int col = 0;
+        for (; col + 4 <= width; col += 4) {
+            __m128i column = _mm_add_epi32(_mm_set1_epi32(start_x + col), _mm_setr_epi32(0, 1, 2, 3));
+            __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(column), _mm_set1_ps(frequency));
+            __m128 floor_x = _mm_floor_ps(x);
+            __m128i ix = _mm_and_si128(_mm_cvttps_epi32(floor_x), byte);
+            __m128 fx = _mm_sub_ps(x, floor_x), fx1 = _mm_sub_ps(fx, _mm_set1_ps(1));
+            __m128 u = terrain_simd::fade(fx);
+
+            __m128i a = _mm_and_si128(_mm_add_epi32(gather(p, ix), iy), byte);
+            __m128i b = _mm_and_si128(_mm_add_epi32(gatherNext(p, ix), iy), byte);
+            __m128i aa = _mm_and_si128(_mm_add_epi32(gather(p, a), iz), byte);
+            __m128i ab = _mm_and_si128(_mm_add_epi32(gatherNext(p, a), iz), byte);
+            __m128i ba = _mm_and_si128(_mm_add_epi32(gather(p, b), iz), byte);
+            __m128i bb = _mm_and_si128(_mm_add_epi32(gatherNext(p, b), iz), byte);
+
+            __m128 q0 = lerp(grad(gather(p, aa), fx, fy, fz), grad(gather(p, ba), fx1, fy, fz), u);
+            __m128 q1 = lerp(grad(gather(p, ab), fx, fy1, fz), grad(gather(p, bb), fx1, fy1, fz), u);
+            __m128 q2 = lerp(grad(gatherNext(p, aa), fx, fy, fz1), grad(gatherNext(p, ba), fx1, fy, fz1), u);
+            __m128 q3 = lerp(grad(gatherNext(p, ab), fx, fy1, fz1), grad(gatherNext(p, bb), fx1, fy1, fz1), u);
+            __m128 n = lerp(lerp(q0, q1, v), lerp(q2, q3, v), w);
+            _mm_storeu_ps(values + row * width + col, n);
+        }
+        for (; col < width; col++) values[row * width + col] = sample(start_x + col, start_z + row, frequency);
+    }
+}
+
+/**
+ * @brief Samples a grid eight columns at a time with AVX2
+ */
+__attribute__((target("avx2")))
+void TerrainNoise::sampleAVX2(int start_x, int start_z, int width, int depth, float frequency, float *values) const {
+    using namespace terrain_simd;
+    const int32_t *p = permutation;
+    const __m256i byte = _mm256_set1_epi32(255);
+    const __m256i iz = _mm256_set1_epi32(plane_iz);
+    const __m256 fz = _mm256_set1_ps(plane_z), fz1 = _mm256_set1_ps(plane_z - 1), w = _mm256_set1_ps(plane_fade);
+    for (int row = 0; row < depth; row++) {
+        float y = (float)(start_z + row) * frequency;
+        float floor_y = std::floor(y);
+        __m256i iy = _mm256_set1_epi32(static_cast<int32_t>(floor_y) & 255);
+        __m256 fy = _mm256_set1_ps(y - floor_y), fy1 = _mm256_set1_ps(y - floor_y - 1);
+        __m256 v = _mm256_set1_ps(fade(y - floor_y));
+
+        int col = 0;
+        for (; col + 8 <= width; col += 8) {
+            __m256i column = _mm256_add_epi32(_mm256_set1_epi32(start_x + col), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+            __m256 x = _mm256_mul_ps(_mm256_cvtepi32_ps(column), _mm256_set1_ps(frequency));
+            __m256 floor_x = _mm256_floor_ps(x);
+            __m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(floor_x), byte);
+            __m256 fx = _mm256_sub_ps(x, floor_x), fx1 = _mm256_sub_ps(fx, _mm256_set1_ps(1));
+            __m256 u = terrain_simd::fade(fx);
+
+            __m256i a = _mm256_and_si256(_mm256_add_epi32(gather(p, ix), iy), byte);
+            __m256i b = _mm256_and_si256(_mm256_add_epi32(gatherNext(p, ix), iy), byte);
+            __m256i aa = _mm256_and_si256(_mm256_add_epi32(gather(p, a), iz), byte);
+            __m256i ab = _mm256_and_si256(_mm256_add_epi32(gatherNext(p, a), iz), byte);
+            __m256i ba = _mm256_and_si256(_mm256_add_epi32(gather(p, b), iz), byte);
+            __m256i bb = _mm256_and_si256(_mm256_add_epi32(gatherNext(p, b), iz), byte);
+
+            __m256 q0 = lerp(grad(gather(p, aa), fx, fy, fz), grad(gather(p, ba), fx1, fy, fz), u);
+            __m256 q1 = lerp(grad(gather(p, ab), fx, fy1, fz), grad(gather(p, bb), fx1, fy1, fz), u);
+            __m256 q2 = lerp(grad(gatherNext(p, aa), fx, fy, fz1), grad(gatherNext(p, ba), fx1, fy, fz1), u);
+            __m256 q3 = lerp(grad(gatherNext(p, ab), fx, fy1, fz1), grad(gatherNext(p, bb), fx1, fy1, fz1), u);
+            __m256 n = lerp(lerp(q0, q1, v), lerp(q2, q3, v), w);
+            _mm256_storeu_ps(values + row * width + col, n);
+        }
+        for (; col < width; col++) values[row * width + col] = sample(start_x + col, start_z + row, frequency);
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef WORLDGENERATOR_H
+#define WORLDGENERATOR_H
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Header Files
+#include "Biome.hpp"
+#include "Chunk.hpp"
+#include "Inventory.hpp"
+#include "TerrainNoise.hpp"
+
+// Utilities
+#include "utils/LruCache.hpp"
+#include "utils/Profiler.hpp"
+#include "utils/WorkerPool.hpp"
+
+/**
+ * @brief Shape of the ground in every column of a chunk
+ * Columns are stored row by row along X, the column at (x, z) inside the chunk is at index z * Chunk::SIZE + x.
+ */
+struct TerrainColumns {
+    constexpr static int COLUMNS = Chunk::SIZE * Chunk::SIZE;
+
+    float heights[COLUMNS]; // Height of the ground, not rounded
+    uint8_t biomes[COLUMNS]; // Index of the biome the column is in
+    float roughness[COLUMNS]; // Height range of the biomes at the column, in blocks
+};
+
+// Stages of generating a chunk whose results are cached, in order. Carving and decoration come after them.
+enum class GenerationStage : uint8_t {
+    BIOMES,  // Biome, base height and height range of every column
+    HEIGHTS, // Height of the ground in every column
+};
+
+/**
+ * @brief Names the result of one stage for one chunk of one world
+ */
+struct StageKey {
+    TerrainNoise::Seed seed;
+    GenerationStage stage;
+    int chunk_x;
+    int chunk_z;
+
+    bool operator==(const StageKey &other) const = default;
+};
+
+struct StageKeyHash {
+    size_t operator()(const StageKey &key) const {
+        // splitmix64 of everything in the key, neighbouring chunks land far apart
+        uint64_t hash = ((uint64_t)key.seed << 8 | (uint64_t)key.stage) * 0x9e3779b97f4a7c15ULL
+                        ^ (uint64_t)(uint32_t)key.chunk_x << 32 ^ (uint32_t)key.chunk_z;
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+        return (size_t)hash;
+    }
+};
+
+// Column results of the early stages, shared between chunks and between generators of different seeds
+using GenerationCache = LruCache<StageKey, std::shared_ptr<const TerrainColumns>, StageKeyHash>;
+
+/**
+ * @brief Decides what the world looks like from its seed
+ * The height of the ground is fractal noise, octaves of the terrain noise at doubling frequency and halving
+ * amplitude, added to a base height. A second noise at a much lower frequency is the biome map: biomes sit at points
+ * along it, and the base height and height range of a column are blended between the two biomes it falls between so
+ * the ground stays smooth across biome borders. The blocks of a column come from the biome it is closest to.
+ *
+ * An octave only adds detail to a column when it moves the ground by more than MIN_DETAIL blocks there, fading in
+ * above that, so flat biomes need fewer octaves than mountains. A chunk stops sampling octaves once none of its
+ * columns needs the next one. Whether a column takes an octave only depends on the column, so chunks that stop at
+ * different octaves still line up at their borders.
+ *
+ * Caves and overhangs are carved out of the filled columns with 3D noise. The noise is only looked up on a coarse
+ * lattice of world positions, every CELL_WIDTH blocks across and CELL_HEIGHT blocks up, and blended between the
+ * corners of each cell, which costs a fraction of a lookup per block. Deep underground the noise hollows out caves,
+ * leaving at least CAVE_ROOF blocks of ground above them. Near the surface of rough biomes it pushes the ground in and
+ * out instead, up to OVERHANG_RISE blocks, making overhangs and undercuts. Every section only reads the lattice at its
+ * own corners, so sections can be carved on any number of threads and give the same blocks.
+ *
+ * Last, decoration picks surface blocks that depend on the neighbouring columns: bare stone on cliffs and sand along
+ * the shore. Columns on the chunk border need the heights of the next chunk over for that.
+ *
+ * A chunk goes through four stages: biome map, heightmap, carving and decoration. The biome map and heightmap of a
+ * chunk are kept in a GenerationCache keyed by seed, stage and chunk, so decorating a chunk finds the heightmaps of
+ * its neighbours there instead of shaping them again, and generating the neighbours later reuses them in turn.
+ * Carved and decorated blocks are only needed by the chunk itself, which is saved as soon as it is generated, so
+ * they have no GenerationStage and are not kept.
+ *
+ * Everything is const after construction and can run on any number of threads at once.
+ */
+class WorldGenerator {
+public:
+    constexpr static int WATER_LEVEL = 5;
+    constexpr static int SUBSURFACE_DEPTH = 3; // Blocks of the subsurface block between the surface and the stone
+    constexpr static int MAX_OCTAVES = 6;
+    constexpr static float BASE_FREQUENCY = 1.0f / 48.0f;   // Noise cells per block of the first octave
+    constexpr static float PERSISTENCE = 0.5f;              // Amplitude of each octave compared to the last
+    constexpr static float MIN_DETAIL = 0.25f;              // Blocks an octave has to move the ground by to be sampled
+    constexpr static float BIOME_FREQUENCY = 1.0f / 256.0f; // Noise cells per block of the biome map
+
+    constexpr static int CELL_WIDTH = 4;                    // Blocks between lattice points of the 3D noise along X and Z
+    constexpr static int CELL_HEIGHT = 8;                   // Blocks between lattice points of the 3D noise along Y
+    constexpr static float CAVE_FREQUENCY = 1.0f / 32.0f;   // Noise cells per block of the first octave of the 3D noise
+    constexpr static int CAVE_OCTAVES = 3;
+    constexpr static float CAVE_THRESHOLD = 0.2f;           // Noise above this is cave
+    constexpr static int CAVE_ROOF = 4;                     // Blocks of ground always left above a cave
+    constexpr static int OVERHANG_RISE = 12;                // Most blocks the noise can push the ground in or out by
+    constexpr static float OVERHANG_ROUGHNESS = 6.0f;       // Height range a biome needs before it gets overhangs
+
+    constexpr static int CLIFF_HEIGHT = 4;                  // Drop to a neighbouring column that leaves bare stone
+    constexpr static size_t CACHE_CAPACITY = 2048;          // Column results kept, a little over 2 KB each
+
+private:
+    struct BiomeStop {
+        float position; // Where the biome sits on the biome map
+        Biome biome;
+    };
+
+    TerrainNoise::Seed seed = 0;
+    TerrainNoise height_noise;
+    TerrainNoise biome_noise;
+    TerrainNoise cave_noise;
+    std::vector<BiomeStop> biomes; // Sorted by position
+    std::shared_ptr<GenerationCache> cache;
+
+public:
+    WorldGenerator() : WorldGenerator(0) {}
+    explicit WorldGenerator(TerrainNoise::Seed seed, std::shared_ptr<GenerationCache> cache = nullptr);
+
+    TerrainNoise::Seed getSeed() const { return seed; }
+    const Biome &getBiome(int index) const { return biomes[index].biome; }
+    GenerationCache &getCache() const { return *cache; }
+
+    void mapBiomes(int chunk_x, int chunk_z, TerrainColumns &columns) const;
+    void shapeHeights(int chunk_x, int chunk_z, TerrainColumns &columns) const;
+    void generateTerrain(int chunk_x, int chunk_z, TerrainColumns &columns) const;
+    std::shared_ptr<const TerrainColumns> biomeMap(int chunk_x, int chunk_z) const;
+    std::shared_ptr<const TerrainColumns> heightmap(int chunk_x, int chunk_z) const;
+    void generateBlocks(const TerrainColumns &columns, Chunk &chunk, WorkerPool *pool = nullptr) const;
+    void carveSection(const TerrainColumns &columns, const int *grounds, const float *overhangs, int chunk_x,
+                      int chunk_z, int section, int *blocks) const;
+    void decorate(int chunk_x, int chunk_z, const int *grounds, int top, int *blocks) const;
+    void generateChunk(Chunk &chunk, WorkerPool *pool = nullptr) const;
+    int surfaceBlock(int x, int z, const Biome &biome) const;
+};
+
+/**
+ * @param seed Seed of the world, every noise is seeded from it
+ * @param cache Where to keep the results of the early stages, or nullptr for a cache of this generator's own. Keys
+ * hold the seed, so generators of different worlds can share one.
+ */
+WorldGenerator::WorldGenerator(TerrainNoise::Seed seed, std::shared_ptr<GenerationCache> cache)
+        : seed(seed), height_noise(seed), biome_noise(seed ^ 0x5bd1e995u), cave_noise(seed ^ 0x27d4eb2fu),
+          cache(cache ? std::move(cache) : std::make_shared<GenerationCache>(CACHE_CAPACITY)) {
+    biomes = {
+            {-0.45f, Biome("Desert", {{SAND, 1}}, SAND, 4.0f, 2.0f)},
+            {-0.1f, Biome("Plains", {{GRASS, 30}, {DIRT, 1}}, DIRT, 7.0f, 3.0f)},
+            {0.2f, Biome("Hills", {{GRASS, 12}, {STONE, 1}}, DIRT, 12.0f, 9.0f)},
+            {0.45f, Biome("Mountains", {{STONE, 8}, {GRASS, 3}, {DIRT, 1}}, STONE, 26.0f, 22.0f)},
+    };
+}
+
+/**
+ * @brief Finds the biome of every column of a chunk, the first stage
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param columns Filled with the biome, roughness and base height of the ground of every column
+ */
+void WorldGenerator::mapBiomes(int chunk_x, int chunk_z, TerrainColumns &columns) const {
+    constexpr int COLUMNS = TerrainColumns::COLUMNS;
+
+    // Blend the biomes on either side of each column
+    float samples[COLUMNS];
+    biome_noise.sample(chunk_x * Chunk::SIZE, chunk_z * Chunk::SIZE, Chunk::SIZE, Chunk::SIZE, BIOME_FREQUENCY, samples);
+    for (int i = 0; i < COLUMNS; i++) {
+        float position = std::clamp(samples[i], biomes.front().position, biomes.back().position);
+        size_t next = 1;
+        while (next + 1 < biomes.size() && biomes[next].position < position) next++;
+        const BiomeStop &low = biomes[next - 1], &high = biomes[next];
+        float t = (position - low.position) / (high.position - low.position);
+        columns.heights[i] = low.biome.getBaseHeight() + (high.biome.getBaseHeight() - low.biome.getBaseHeight()) * t;
+        columns.roughness[i] = low.biome.getHeightRange() + (high.biome.getHeightRange() - low.biome.getHeightRange()) * t;
+        columns.biomes[i] = (uint8_t)(t < 0.5f ? next - 1 : next);
+    }
+}
+
+/**
+ * @brief Adds the octaves of the height noise to the base height of every column, the second stage
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param columns Biome map from mapBiomes(), its heights become the heights of the ground
+ */
+void WorldGenerator::shapeHeights(int chunk_x, int chunk_z, TerrainColumns &columns) const {
+    constexpr int COLUMNS = TerrainColumns::COLUMNS;
+    const int start_x = chunk_x * Chunk::SIZE, start_z = chunk_z * Chunk::SIZE;
+    float samples[COLUMNS];
+    float max_range = *std::max_element(columns.roughness, columns.roughness + COLUMNS);
+
+    float amplitude = 1.0f, frequency = BASE_FREQUENCY;
+    for (int octave = 0; octave < MAX_OCTAVES; octave++) {
+        // No column of the chunk is rough enough for this octave or any after it
+        if (amplitude * max_range <= MIN_DETAIL) break;
+        height_noise.sample(start_x, start_z, Chunk::SIZE, Chunk::SIZE, frequency, samples);
+        for (int i = 0; i < COLUMNS; i++) {
+            float blocks = amplitude * columns.roughness[i];
+            float weight = std::clamp((blocks - MIN_DETAIL) / MIN_DETAIL, 0.0f, 1.0f);
+            columns.heights[i] += blocks * weight * samples[i];
+        }
+        amplitude *= PERSISTENCE;
+        frequency *= 2.0f;
+    }
+
+    for (int i = 0; i < COLUMNS; i++) columns.heights[i] = std::clamp(columns.heights[i], 1.0f, (float)(Chunk::HEIGHT - 2));
+}
+
+/**
+ * @brief Finds the height and biome of every column of a chunk without going through the cache
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param columns Filled with the shape of the ground
+ */
+void WorldGenerator::generateTerrain(int chunk_x, int chunk_z, TerrainColumns &columns) const {
+    mapBiomes(chunk_x, chunk_z, columns);
+    shapeHeights(chunk_x, chunk_z, columns);
+}
+
+/**
+ * @brief Biome map of a chunk from the cache, mapped and cached if it is not there
+ */
+std::shared_ptr<const TerrainColumns> WorldGenerator::biomeMap(int chunk_x, int chunk_z) const {
+    StageKey key{seed, GenerationStage::BIOMES, chunk_x, chunk_z};
+    std::shared_ptr<const TerrainColumns> columns;
+    if (cache->find(key, columns)) return columns;
+    auto mapped = std::make_shared<TerrainColumns>();
+    mapBiomes(chunk_x, chunk_z, *mapped);
+    cache->insert(key, mapped);
+    return mapped;
+}
+
+/**
+ * @brief Heightmap of a chunk from the cache, shaped from the cached biome map and cached if it is not there
+ */
+std::shared_ptr<const TerrainColumns> WorldGenerator::heightmap(int chunk_x, int chunk_z) const {
+    StageKey key{seed, GenerationStage::HEIGHTS, chunk_x, chunk_z};
+    std::shared_ptr<const TerrainColumns> columns;
+    if (cache->find(key, columns)) return columns;
+    PROFILE_SCOPE("WorldGenerator::heightmap");
+    auto shaped = std::make_shared<TerrainColumns>(*biomeMap(chunk_x, chunk_z));
+    shapeHeights(chunk_x, chunk_z, *shaped);
+    cache->insert(key, shaped);
+    return shaped;
+}
+
+/**
+ * @brief Fills every column of a chunk from the bottom of the world up to the ground, and with water up to the water
+ * level where the ground is lower, then carves caves and overhangs into it and decorates the surface
+ * Each column is bedrock, stone, a few blocks of the subsurface block of its biome and a surface block. Every layer
+ * is written as one run into a plain array of block ids. Each section is then carved on its own, the surface is
+ * decorated, and each section is packed from the array on its own.
+ *
+ * @param columns Shape of the ground from generateTerrain()
+ * @param chunk Chunk to fill, should be empty
+ * @param pool Workers to carve the sections on alongside the calling thread, or nullptr to carve them all on it
+ */
+void WorldGenerator::generateBlocks(const TerrainColumns &columns, Chunk &chunk, WorkerPool *pool) const {
+    constexpr int LAYER = Chunk::SIZE * Chunk::SIZE;
+    int grounds[TerrainColumns::COLUMNS];
+    float overhangs[TerrainColumns::COLUMNS]; // How far the 3D noise pushes the ground around, 0 to 1
+    int top = WATER_LEVEL + 1;
+    for (int i = 0; i < TerrainColumns::COLUMNS; i++) {
+        grounds[i] = (int)std::round(columns.heights[i]);
+        // Columns at the water stay as they are, so no water is left floating or cut open
+        overhangs[i] = grounds[i] <= WATER_LEVEL + 1 ? 0.0f
+                : std::clamp((columns.roughness[i] - OVERHANG_ROUGHNESS) / OVERHANG_ROUGHNESS, 0.0f, 1.0f);
+        top = std::max(top, grounds[i] + 1 + (overhangs[i] > 0 ? OVERHANG_RISE : 0));
+    }
+    // Whole sections only, everything above the highest one stays air
+    top = std::min(Chunk::HEIGHT, (top + Chunk::SIZE - 1) / Chunk::SIZE * Chunk::SIZE);
+
+    std::vector<int> blocks(top * LAYER, AIR);
+    auto run = [&](int column, int y_begin, int y_end, int block_id) {
+        for (int y = y_begin; y < y_end; y++) blocks[y * LAYER + column] = block_id;
+    };
+    for (int z = 0; z < Chunk::SIZE; z++) {
+        for (int x = 0; x < Chunk::SIZE; x++) {
+            int column = z * Chunk::SIZE + x;
+            const Biome &biome = getBiome(columns.biomes[column]);
+            int ground = grounds[column];
+            int subsurface = std::max(1, ground - SUBSURFACE_DEPTH);
+
+            run(column, 0, 1, BEDROCK);
+            run(column, 1, subsurface, STONE);
+            run(column, subsurface, ground, biome.getSubsurfaceBlock());
+            run(column, ground, ground + 1, surfaceBlock(chunk.getX() * Chunk::SIZE + x, chunk.getZ() * Chunk::SIZE + z, biome));
+            run(column, ground + 1, WATER_LEVEL + 1, WATER);
+        }
+    }
+
+    auto carve = [&](int section) {
+        PROFILE_SCOPE("WorldGenerator::carveSection");
+        carveSection(columns, grounds, overhangs, chunk.getX(), chunk.getZ(), section,
+                     blocks.data() + section * ChunkSection::VOLUME);
+    };
+    auto pack = [&](int section) {
+        PROFILE_SCOPE("Chunk::assign");
+        chunk.assign(section, blocks.data() + section * ChunkSection::VOLUME);
+    };
+    int sections = top / Chunk::SIZE;
+    if (pool) pool->parallelFor(sections, carve);
+    else for (int section = 0; section < sections; section++) carve(section);
+    decorate(chunk.getX(), chunk.getZ(), grounds, top, blocks.data());
+    if (pool) pool->parallelFor(sections, pack);
+    else for (int section = 0; section < sections; section++) pack(section);
+}
+
+/**
+ * @brief Carves caves and overhangs into one filled section
+ * @param columns Shape of the ground from generateTerrain()
+ * @param grounds Height of the ground in every column, rounded
+ * @param overhangs How far the noise pushes the ground around in every column, from 0 for not at all to 1 for up to
+ * OVERHANG_RISE blocks
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param section Index of the section from the bottom
+ * @param blocks ChunkSection::VOLUME block ids of the section in storage order, carved in place
+ */
+void WorldGenerator::carveSection(const TerrainColumns &columns, const int *grounds, const float *overhangs,
+                                  int chunk_x, int chunk_z, int section, int *blocks) const {
+    static_assert(Chunk::SIZE % CELL_WIDTH == 0 && Chunk::SIZE % CELL_HEIGHT == 0, "Cells have to tile a section");
+    constexpr int POINTS_XZ = Chunk::SIZE / CELL_WIDTH + 1, POINTS_Y = Chunk::SIZE / CELL_HEIGHT + 1;
+    const int start_x = chunk_x * Chunk::SIZE, start_y = section * Chunk::SIZE, start_z = chunk_z * Chunk::SIZE;
+
+    // Lattice points sit at world positions, so neighbouring sections and chunks agree on the points they share
+    float lattice[POINTS_Y][POINTS_XZ][POINTS_XZ];
+    for (int py = 0; py < POINTS_Y; py++) {
+        for (int pz = 0; pz < POINTS_XZ; pz++) {
+            for (int px = 0; px < POINTS_XZ; px++) {
+                lattice[py][pz][px] = cave_noise.sample(start_x + px * CELL_WIDTH, start_y + py * CELL_HEIGHT,
+                                                        start_z + pz * CELL_WIDTH, CAVE_FREQUENCY, CAVE_OCTAVES);
+            }
+        }
+    }
+    auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+
+    for (int y = 0; y < Chunk::SIZE; y++) {
+        int world_y = start_y + y;
+        if (world_y == 0) continue; // Bedrock
+        int py = y / CELL_HEIGHT;
+        float ty = (float)(y % CELL_HEIGHT) / CELL_HEIGHT;
+        for (int z = 0; z < Chunk::SIZE; z++) {
+            int pz = z / CELL_WIDTH;
+            float tz = (float)(z % CELL_WIDTH) / CELL_WIDTH;
+            for (int x = 0; x < Chunk::SIZE; x++) {
+                int column = z * Chunk::SIZE + x;
+                int depth = grounds[column] - world_y; // 0 at the surface block, negative above it
+                float overhang = overhangs[column];
+                // Too far above the ground for anything to reach, or close to it where the ground is not pushed around
+                if (depth < -OVERHANG_RISE || (depth < CAVE_ROOF && overhang == 0)) continue;
+
+                int px = x / CELL_WIDTH;
+                float tx = (float)(x % CELL_WIDTH) / CELL_WIDTH;
+                float density = lerp(
+                        lerp(lerp(lattice[py][pz][px], lattice[py][pz][px + 1], tx),
+                             lerp(lattice[py][pz + 1][px], lattice[py][pz + 1][px + 1], tx), tz),
+                        lerp(lerp(lattice[py + 1][pz][px], lattice[py + 1][pz][px + 1], tx),
+                             lerp(lattice[py + 1][pz + 1][px], lattice[py + 1][pz + 1][px + 1], tx), tz), ty);
+
+                int &block = blocks[(y * Chunk::SIZE + z) * Chunk::SIZE + x];
+                if (depth >= CAVE_ROOF) {
+                    if (density > CAVE_THRESHOLD) block = AIR;
+                    continue;
+                }
+                bool solid = (float)depth + density * overhang * OVERHANG_RISE >= 0;
+                if (solid && depth < 0) block = getBiome(columns.biomes[column]).getSubsurfaceBlock();
+                else if (!solid && depth >= 0) block = AIR;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Picks the surface blocks that depend on the neighbouring columns, the last stage
+ * Columns that drop CLIFF_HEIGHT blocks or more to a neighbour are bare stone down through the subsurface, and
+ * columns at the water line next to water are sand. Blocks that were carved away are left alone.
+ *
+ * @param chunk_x X position of the chunk
+ * @param chunk_z Z position of the chunk
+ * @param grounds Height of the ground in every column, rounded
+ * @param top Number of layers in blocks
+ * @param blocks Carved block ids of the chunk in storage order, decorated in place
+ */
+void WorldGenerator::decorate(int chunk_x, int chunk_z, const int *grounds, int top, int *blocks) const {
+    PROFILE_SCOPE("WorldGenerator::decorate");
+    constexpr int SIZE = Chunk::SIZE, LAYER = SIZE * SIZE, PADDED = SIZE + 2;
+    // Grounds with a border of the columns next to the chunk, which come from the cached neighbour heightmaps
+    int around[PADDED * PADDED];
+    auto at = [](int x, int z) { return (z + 1) * PADDED + x + 1; };
+    for (int z = 0; z < SIZE; z++) {
+        for (int x = 0; x < SIZE; x++) around[at(x, z)] = grounds[z * SIZE + x];
+    }
+    auto west = heightmap(chunk_x - 1, chunk_z), east = heightmap(chunk_x + 1, chunk_z);
+    auto north = heightmap(chunk_x, chunk_z - 1), south = heightmap(chunk_x, chunk_z + 1);
+    for (int i = 0; i < SIZE; i++) {
+        around[at(-1, i)] = (int)std::round(west->heights[i * SIZE + SIZE - 1]);
+        around[at(SIZE, i)] = (int)std::round(east->heights[i * SIZE]);
+        around[at(i, -1)] = (int)std::round(north->heights[(SIZE - 1) * SIZE + i]);
+        around[at(i, SIZE)] = (int)std::round(south->heights[i]);
+    }
+
+    for (int z = 0; z < SIZE; z++) {
+        for (int x = 0; x < SIZE; x++) {
+            int ground = around[at(x, z)];
+            int lowest = std::min({around[at(x - 1, z)], around[at(x + 1, z)], around[at(x, z - 1)], around[at(x, z + 1)]});
+            int block_id;
+            if (ground - lowest >= CLIFF_HEIGHT) block_id = STONE;
+            else if (ground >= WATER_LEVEL && ground <= WATER_LEVEL + 1 && lowest < WATER_LEVEL) block_id = SAND;
+            else continue;
+
+            int column = z * SIZE + x;
+            for (int y = std::max(1, ground - SUBSURFACE_DEPTH); y <= ground && y < top; y++) {
+                int &block = blocks[y * LAYER + column];
+                if (block != AIR && block != WATER) block = block_id;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Generates every block of a chunk, going through every stage
+ * @param chunk Chunk to fill, should be empty
+ * @param pool Workers to carve the sections on alongside the calling thread, or nullptr to carve them all on it
+ */
+void WorldGenerator::generateChunk(Chunk &chunk, WorkerPool *pool) const {
+    generateBlocks(*heightmap(chunk.getX(), chunk.getZ()), chunk, pool);
+}
+
+/**
+ * @brief Picks the top block of a column from the blocks of its biome
+ * @param x X position of the column
+ * @param z Z position of the column
+ * @param biome Biome of the column
+ * @return Block id
+ */
+int WorldGenerator::surfaceBlock(int x, int z, const Biome &biome) const {
+    // splitmix64 of the seed and the column, so the pick is random looking but the same every time
+    uint64_t key = (uint64_t)seed * 0x9e3779b97f4a7c15ULL ^ (uint64_t)(uint32_t)x << 32 ^ (uint32_t)z;
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return biome.pickSurfaceBlock((uint32_t)key);
+}
+
+#endif
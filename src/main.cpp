@@ -1,9 +1,18 @@
 #include "BetterBlox.hpp"
 #include "utils/RuntimeError.hpp"
 
-int main() {
+#include <cstring>
+
+int main(int argc, char **argv) {
+    // --instanced draws every block as an instance of the cube instead of one mesh per chunk, for comparing the two
+    RenderMode render_mode = RenderMode::MESHED;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--instanced") == 0)
+            render_mode = RenderMode::INSTANCED;
+    }
+
     try {
-        BetterBlox game;
+        BetterBlox game(render_mode);
         game.run();
     }
     catch (RuntimeError &err) {
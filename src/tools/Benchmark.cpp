@@ -0,0 +1,271 @@
+// Times the hot paths of the game (chunk storage, noise, block hashing, world generation, meshing and culling) with a
+// fixed seed so runs can be compared across releases. Every benchmark reports nanoseconds per operation and items
+// per second. Saves go to a scratch directory under the system temp directory, which is emptied first.
+// Usage: betterblox_bench [--json] [--filter text] [--min-time seconds]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "../Block.hpp"
+#include "../ChunkLoader.hpp"
+#include "../ChunkMesher.hpp"
+#include "../Frustum.hpp"
+#include "../OcclusionCuller.hpp"
+#include "../PerlinNoise.hpp"
+#include "../TerrainNoise.hpp"
+#include "../WorldGenerator.hpp"
+
+constexpr TerrainNoise::Seed SEED = 12345;
+constexpr int REPEATS = 5;             // Timed runs per benchmark, the fastest one is reported
+constexpr uint64_t MAX_OPS = 1u << 30; // Stops calibration on benchmarks too fast to time
+
+struct Result {
+    std::string name;
+    std::string item;
+    uint64_t ops;
+    double ns_per_op;
+    double items_per_second;
+};
+
+struct Options {
+    bool json = false;
+    std::string filter;
+    double min_time = 0.1; // Seconds each timed run should take at least
+};
+
+// Results are added in here so the compiler cannot drop the work that made them
+static volatile uint64_t sink = 0;
+
+static void keep(uint64_t value) { sink = sink + value; }
+
+/**
+ * @brief Times a benchmark and adds its result
+ * The number of operations is doubled until one run takes min_time, then the fastest of REPEATS runs is kept.
+ *
+ * @param name Name of the benchmark, group/name
+ * @param item What an item is, for items per second
+ * @param items_per_op Items one operation handles
+ * @param fn Runs the given number of operations
+ */
+template<class Fn>
+void measure(const Options &options, std::vector<Result> &results, const std::string &name, const std::string &item,
+             double items_per_op, Fn &&fn) {
+    if (name.find(options.filter) == std::string::npos) return;
+    auto time = [&](uint64_t ops) {
+        auto start = std::chrono::steady_clock::now();
+        fn(ops);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    uint64_t ops = 1;
+    double seconds = time(ops);
+    while (seconds < options.min_time && ops < MAX_OPS) {
+        ops *= 2;
+        seconds = time(ops);
+    }
+    for (int i = 1; i < REPEATS; i++) seconds = std::min(seconds, time(ops));
+
+    Result result{name, item, ops, seconds * 1e9 / (double)ops, (double)ops * items_per_op / seconds};
+    results.push_back(result);
+    if (!options.json) {
+        std::cout << std::left << std::setw(36) << name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << result.ns_per_op << " ns/op" << std::setw(16) << std::setprecision(0)
+                  << result.items_per_second << " " << item << "/s" << std::endl;
+    }
+}
+
+void printJson(const std::vector<Result> &results) {
+    std::cout << "{\n  \"seed\": " << SEED << ",\n  \"noise_kernel\": \""
+              << TerrainNoise::kernelName(TerrainNoise::bestKernel()) << "\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &result = results[i];
+        std::cout << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops << ", \"ns_per_op\": "
+                  << std::setprecision(6) << result.ns_per_op << ", \"items_per_second\": " << result.items_per_second
+                  << ", \"item\": \"" << result.item << "\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json") options.json = true;
+        else if (arg == "--filter" && i + 1 < argc) options.filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) options.min_time = std::atof(argv[++i]);
+        else {
+            std::cerr << "Usage: betterblox_bench [--json] [--filter text] [--min-time seconds]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "betterblox_bench";
+    std::filesystem::remove_all(scratch);
+    std::filesystem::create_directories(scratch);
+    std::filesystem::current_path(scratch);
+    ChunkLoader::setSeed(SEED);
+
+    std::vector<Result> results;
+    constexpr int SIZE = Chunk::SIZE;
+    constexpr int COLUMNS = SIZE * SIZE;
+
+    // Noise
+    TerrainNoise noise(SEED);
+    std::vector<float> values(COLUMNS);
+    for (auto kernel : {TerrainNoise::Kernel::SCALAR, TerrainNoise::Kernel::SSE41, TerrainNoise::Kernel::AVX2}) {
+        if (!TerrainNoise::isSupported(kernel)) continue;
+        measure(options, results, std::string("noise/terrain_grid_") + TerrainNoise::kernelName(kernel), "columns",
+                COLUMNS, [&](uint64_t ops) {
+                    for (uint64_t i = 0; i < ops; i++) {
+                        noise.sample((int)(i % 64) * SIZE, (int)(i / 64 % 64) * SIZE, SIZE, SIZE, 0.15f, values.data(),
+                                     kernel);
+                        keep((uint64_t)(values[i % COLUMNS] * 1000));
+                    }
+                });
+    }
+    siv::BasicPerlinNoise<float> perlin(SEED);
+    measure(options, results, "noise/octave2D_4", "samples", 1, [&](uint64_t ops) {
+        float total = 0;
+        for (uint64_t i = 0; i < ops; i++) total += perlin.octave2D((float)(i % 1024) * 0.03f, (float)(i / 1024) * 0.03f, 4);
+        keep((uint64_t)(total * 1000));
+    });
+
+    // Block hashing
+    constexpr int BLOCKS = 4096;
+    std::vector<Block> blocks;
+    for (int i = 0; i < BLOCKS; i++) blocks.emplace_back(glm::vec3(i % SIZE, i / COLUMNS, i / SIZE % SIZE), GRASS);
+    measure(options, results, "block/hash", "hashes", BLOCKS, [&](uint64_t ops) {
+        std::hash<Block> hash;
+        for (uint64_t i = 0; i < ops; i++) {
+            for (const Block &block : blocks) keep(hash(block));
+        }
+    });
+    measure(options, results, "block/set_insert", "blocks", BLOCKS, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            std::unordered_set<Block> set;
+            for (const Block &block : blocks) set.insert(block);
+            keep(set.size());
+        }
+    });
+    std::unordered_set<Block> block_set(blocks.begin(), blocks.end());
+    measure(options, results, "block/set_find", "lookups", BLOCKS, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            for (const Block &block : blocks) keep(block_set.count(block));
+        }
+    });
+
+    // Chunk storage, every operation writes to chunks nothing has written to yet
+    int next_chunk = 0;
+    auto freshChunk = [&](int &chunk_x, int &chunk_z) {
+        chunk_x = 1000 + next_chunk % 256;
+        chunk_z = next_chunk / 256;
+        next_chunk++;
+    };
+    measure(options, results, "chunkloader/write_read_layer", "blocks", COLUMNS, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            int chunk_x, chunk_z;
+            freshChunk(chunk_x, chunk_z);
+            for (int z = 0; z < SIZE; z++) {
+                for (int x = 0; x < SIZE; x++) {
+                    int world_x = chunk_x * SIZE + x, world_z = chunk_z * SIZE + z;
+                    ChunkLoader::writeFile(glm::vec3(world_x, 1, world_z), GRASS, world_x, world_z);
+                }
+            }
+            Chunk chunk(chunk_x, chunk_z);
+            ChunkLoader::readFile(chunk_x, chunk_z, chunk);
+            keep(chunk.getTop());
+        }
+    });
+    measure(options, results, "chunkloader/update_chunk", "chunks", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            int chunk_x, chunk_z;
+            freshChunk(chunk_x, chunk_z);
+            ChunkLoader::updateChunk(chunk_x, chunk_z);
+        }
+    });
+    for (int i = 0; i < 64; i++) ChunkLoader::updateChunk(i % 8, i / 8);
+    measure(options, results, "chunkloader/read_chunk", "chunks", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            Chunk chunk((int)(i % 8), (int)(i / 8 % 8));
+            ChunkLoader::readFile(chunk.getX(), chunk.getZ(), chunk);
+            keep(chunk.getTop());
+        }
+    });
+
+    // World generation, in memory only
+    WorldGenerator generator(SEED);
+    TerrainColumns columns;
+    measure(options, results, "worldgen/terrain", "chunks", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            generator.generateTerrain((int)(i % 256), (int)(i / 256), columns);
+            keep((uint64_t)columns.heights[i % COLUMNS]);
+        }
+    });
+    measure(options, results, "worldgen/chunk", "chunks", 1, [&](uint64_t ops) {
+        // Every run starts cold, otherwise the runs after the first only find the heightmaps in the cache. Within a
+        // run the neighbours' heightmaps are still reused, like while streaming.
+        generator.getCache().clear();
+        for (uint64_t i = 0; i < ops; i++) {
+            Chunk chunk((int)(i % 256), (int)(i / 256));
+            generator.generateChunk(chunk);
+            keep(chunk.getTop());
+        }
+    });
+
+    // Meshing and culling over a patch of generated chunks
+    constexpr int PATCH = 17;
+    std::vector<Chunk> patch;
+    for (int i = 0; i < PATCH * PATCH; i++) {
+        patch.emplace_back(i % PATCH - PATCH / 2, i / PATCH - PATCH / 2);
+        generator.generateChunk(patch.back());
+    }
+    const Chunk &center = patch[PATCH * PATCH / 2];
+    ChunkNeighbours neighbours{&patch[PATCH * PATCH / 2 - 1], &patch[PATCH * PATCH / 2 + 1],
+                               &patch[PATCH * PATCH / 2 - PATCH], &patch[PATCH * PATCH / 2 + PATCH]};
+    measure(options, results, "mesher/greedy", "chunks", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) keep(ChunkMesher::build(center, neighbours).vertices.size());
+    });
+    measure(options, results, "mesher/instances", "chunks", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) keep(ChunkMesher::buildInstances(center, neighbours).instances.size());
+    });
+
+    OcclusionCuller culler;
+    measure(options, results, "culler/update", "chunks", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) culler.update(patch[i % patch.size()]);
+    });
+    for (const Chunk &chunk : patch) culler.update(chunk);
+    measure(options, results, "culler/search_8", "searches", 1, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) {
+            culler.search(glm::vec3(8.0f, 40.0f, 8.0f), PATCH / 2);
+            keep(culler.isVisible(PATCH / 2, 0));
+        }
+    });
+
+    BoxBatch boxes;
+    std::mt19937 random(SEED);
+    std::uniform_real_distribution<float> spread(-512.0f, 512.0f);
+    for (int i = 0; i < BLOCKS; i++) {
+        glm::vec3 min(spread(random), spread(random) / 8.0f, spread(random));
+        boxes.add(min, min + glm::vec3(SIZE));
+    }
+    Frustum frustum(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f) *
+                    glm::lookAt(glm::vec3(0.0f, 40.0f, 0.0f), glm::vec3(1.0f, 40.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    std::vector<uint8_t> visible;
+    measure(options, results, "frustum/cull", "boxes", BLOCKS, [&](uint64_t ops) {
+        for (uint64_t i = 0; i < ops; i++) keep(frustum.cull(boxes, visible));
+    });
+
+    if (options.json) printJson(results);
+    return 0;
+}
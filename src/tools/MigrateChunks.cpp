@@ -0,0 +1,14 @@
+// Moves a world saved as one `Chunk(x,z).bin` file per chunk into region files.
+// Usage: betterblox_migrate [save directory]
+
+#include <iostream>
+#include <string>
+
+#include "../ChunkLoader.hpp"
+
+int main(int argc, char **argv) {
+    std::string directory = (argc > 1) ? argv[1] : ".";
+    int migrated = ChunkLoader::migrateChunkFiles(directory);
+    std::cout << "Migrated " << migrated << " chunk files in " << directory << std::endl;
+    return 0;
+}
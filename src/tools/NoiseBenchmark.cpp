@@ -0,0 +1,72 @@
+// Measures how many chunks of noise each terrain noise kernel fills per second and checks they all agree, then how
+// many chunks of terrain the world generator shapes per second.
+// Usage: betterblox_noise_bench [chunks] [target terrain chunks per second]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "../WorldGenerator.hpp"
+
+// Terrain has to keep up with streaming on one worker with plenty to spare for saving and meshing
+constexpr double TERRAIN_TARGET = 20000;
+
+int main(int argc, char **argv) {
+    constexpr int SIZE = Chunk::SIZE;
+    constexpr float FREQUENCY = 0.15f;
+    int chunks = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    double target = (argc > 2) ? std::atof(argv[2]) : TERRAIN_TARGET;
+    int side = 1;
+    while (side * side < chunks) side++;
+
+    TerrainNoise noise(12345);
+    std::vector<float> expected(SIZE * SIZE), values(SIZE * SIZE);
+    int failed = 0;
+    for (auto kernel : {TerrainNoise::Kernel::SCALAR, TerrainNoise::Kernel::SSE41, TerrainNoise::Kernel::AVX2}) {
+        if (!TerrainNoise::isSupported(kernel)) {
+            std::cout << TerrainNoise::kernelName(kernel) << ": not supported" << std::endl;
+            continue;
+        }
+
+        float checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < chunks; i++) {
+            int chunk_x = i % side - side / 2, chunk_z = i / side - side / 2;
+            noise.sample(chunk_x * SIZE, chunk_z * SIZE, SIZE, SIZE, FREQUENCY, values.data(), kernel);
+            checksum += values[i % (SIZE * SIZE)];
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // Every kernel has to give the same bits as the scalar lookup
+        int mismatches = 0;
+        for (int i = 0; i < chunks; i += 97) {
+            int chunk_x = i % side - side / 2, chunk_z = i / side - side / 2;
+            noise.sample(chunk_x * SIZE, chunk_z * SIZE, SIZE, SIZE, FREQUENCY, expected.data(), TerrainNoise::Kernel::SCALAR);
+            noise.sample(chunk_x * SIZE, chunk_z * SIZE, SIZE, SIZE, FREQUENCY, values.data(), kernel);
+            mismatches += std::memcmp(expected.data(), values.data(), expected.size() * sizeof(float)) != 0;
+        }
+        failed += mismatches;
+
+        std::cout << TerrainNoise::kernelName(kernel) << ": " << chunks / elapsed.count() << " chunks/s, "
+                  << elapsed.count() * 1e9 / ((double)chunks * SIZE * SIZE) << " ns/column"
+                  << (mismatches ? ", DOES NOT MATCH SCALAR" : "") << " (checksum " << checksum << ")" << std::endl;
+    }
+
+    WorldGenerator generator(12345);
+    TerrainColumns columns;
+    float checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < chunks; i++) {
+        generator.generateTerrain(i % side - side / 2, i / side - side / 2, columns);
+        checksum += columns.heights[i % TerrainColumns::COLUMNS];
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double rate = chunks / elapsed.count();
+    std::cout << "terrain: " << rate << " chunks/s, target " << target << " (checksum " << checksum << ")"
+              << (rate < target ? ", BELOW TARGET" : "") << std::endl;
+    if (rate < target) failed++;
+
+    return failed == 0 ? 0 : 1;
+}
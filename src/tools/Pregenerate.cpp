@@ -0,0 +1,84 @@
+// Generates and saves every chunk in an area around a center chunk without opening a window, using every core.
+// Chunks that are already saved are left alone. Run it in the save directory of the world.
+// Usage: betterblox_pregen [radius in chunks] [square|circle] [center chunk x] [center chunk z] [threads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../ChunkLoader.hpp"
+
+// Chunk columns generated side by side before moving on, so the heightmaps of the last row are still cached
+constexpr int BAND_WIDTH = 32;
+
+int main(int argc, char **argv) {
+    int radius = (argc > 1) ? std::atoi(argv[1]) : 32;
+    std::string shape = (argc > 2) ? argv[2] : "square";
+    int center_x = (argc > 3) ? std::atoi(argv[3]) : 0;
+    int center_z = (argc > 4) ? std::atoi(argv[4]) : 0;
+    unsigned threads = (argc > 5) ? (unsigned)std::atoi(argv[5]) : std::thread::hardware_concurrency();
+    if (radius < 0 || (shape != "square" && shape != "circle")) {
+        std::cerr << "Usage: betterblox_pregen [radius in chunks] [square|circle] [center chunk x] [center chunk z] [threads]"
+                  << std::endl;
+        return 1;
+    }
+    threads = std::max(1u, threads);
+
+    ChunkLoader::migrateChunkFiles(".");
+    TerrainNoise::Seed seed = ChunkLoader::loadSeed(".");
+
+    std::vector<std::pair<int, int>> chunks;
+    for (int band = -radius; band <= radius; band += BAND_WIDTH) {
+        for (int z = -radius; z <= radius; z++) {
+            for (int x = band; x < band + BAND_WIDTH && x <= radius; x++) {
+                if (shape == "circle" && x * x + z * z > radius * radius) continue;
+                chunks.emplace_back(center_x + x, center_z + z);
+            }
+        }
+    }
+    std::cout << "Generating " << chunks.size() << " chunks around (" << center_x << ", " << center_z << ") from seed "
+              << seed << " on " << threads << " threads" << std::endl;
+
+    std::atomic<int> generated{0}, skipped{0}, finished{0};
+    std::mutex print_mutex;
+    int report_every = std::max<int>(1, (int)chunks.size() / 10);
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+    auto generate = [&](int i) {
+        auto [chunk_x, chunk_z] = chunks[i];
+        if (ChunkLoader::checkFile(chunk_x, chunk_z)) {
+            skipped++;
+        } else {
+            Chunk chunk(chunk_x, chunk_z);
+            ChunkLoader::generateChunk(chunk);
+            generated++;
+        }
+        int done = ++finished;
+        if (done % report_every == 0) {
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << done << " / " << chunks.size() << " chunks, " << generated / elapsed() << " chunks/s" << std::endl;
+        }
+    };
+    if (threads == 1) {
+        for (int i = 0; i < (int)chunks.size(); i++) generate(i);
+    } else {
+        // The calling thread works alongside the pool, so there are as many threads as asked for
+        WorkerPool pool(threads - 1);
+        pool.parallelFor((int)chunks.size(), generate);
+    }
+
+    double seconds = elapsed();
+    uint64_t bytes = ChunkLoader::stats().bytes_written;
+    std::cout << "Generated " << generated << " chunks (" << skipped << " already saved) in " << seconds << " s: "
+              << generated / seconds << " chunks/s, " << bytes << " bytes written, "
+              << bytes / seconds / (1024 * 1024) << " MB/s" << std::endl;
+    return 0;
+}
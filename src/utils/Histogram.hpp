@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Counts of values in buckets that get wider as the values grow, like an HDR histogram
+ * Values below 2^SUB_BUCKET_BITS get a bucket each. Above that every power of two is split into 2^(SUB_BUCKET_BITS-1)
+ * equal buckets, so a bucket is never wider than 1/64 of the values in it and percentiles are within about 1.6% of
+ * the real value for any value a uint64_t holds. The buckets are one fixed array, so recording is a count of leading
+ * zeros and an increment and never allocates.
+ *
+ * Not thread safe, record from one thread or merge histograms of different threads.
+ */
+class Histogram {
+public:
+    constexpr static int SUB_BUCKET_BITS = 7;
+    constexpr static uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    constexpr static uint64_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+    constexpr static size_t BUCKETS = (64 - SUB_BUCKET_BITS) * HALF_SUB_BUCKETS + SUB_BUCKETS;
+
+private:
+    std::array<uint64_t, BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t lowest = std::numeric_limits<uint64_t>::max();
+    uint64_t highest = 0;
+
+    static size_t bucketOf(uint64_t value) {
+        int shift = std::max(0, (int)std::bit_width(value) - SUB_BUCKET_BITS);
+        return (size_t)shift * HALF_SUB_BUCKETS + (size_t)(value >> shift);
+    }
+
+    /**
+     * @brief Largest value that falls in a bucket
+     */
+    static uint64_t highestIn(size_t bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        int shift = (int)(bucket / HALF_SUB_BUCKETS) - 1;
+        uint64_t top = bucket - (uint64_t)shift * HALF_SUB_BUCKETS;
+        return ((top + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t value) {
+        counts[bucketOf(value)]++;
+        total++;
+        sum += value;
+        lowest = std::min(lowest, value);
+        highest = std::max(highest, value);
+    }
+
+    /**
+     * @brief Adds every value recorded in another histogram
+     */
+    void merge(const Histogram &other) {
+        for (size_t i = 0; i < BUCKETS; i++) counts[i] += other.counts[i];
+        total += other.total;
+        sum += other.sum;
+        lowest = std::min(lowest, other.lowest);
+        highest = std::max(highest, other.highest);
+    }
+
+    void reset() {
+        counts.fill(0);
+        total = 0;
+        sum = 0;
+        lowest = std::numeric_limits<uint64_t>::max();
+        highest = 0;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? lowest : 0; }
+    uint64_t max() const { return highest; }
+    double mean() const { return total ? (double)sum / (double)total : 0.0; }
+
+    /**
+     * @brief Value that the given share of the recorded values are at or below
+     * @param percent 0 to 100, 50 is the median
+     * @return Highest value of the bucket the percentile falls in, never above max(), or 0 if nothing was recorded
+     */
+    uint64_t percentile(double percent) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * (double)total);
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(highestIn(i), highest);
+        }
+        return highest;
+    }
+};
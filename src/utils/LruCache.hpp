@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief Map that holds at most a fixed number of values and forgets the least recently used one to make room
+ * Values are kept in a list from most to least recently used, with a hash map from keys into the list, so finding,
+ * inserting and evicting are all constant time. Every call takes one lock, values should be cheap to copy (a
+ * shared_ptr to the real data) so the lock is held only briefly.
+ *
+ * @tparam K Key type
+ * @tparam V Value type, must be copyable
+ * @tparam Hash Hash of K
+ */
+template<class K, class V, class Hash = std::hash<K>>
+class LruCache {
+private:
+    using Entry = std::pair<K, V>;
+
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<K, typename std::list<Entry>::iterator, Hash> index;
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::atomic<uint64_t> hit_count{0};
+    std::atomic<uint64_t> miss_count{0};
+
+public:
+    /**
+     * @param capacity Most values held at once, at least 1
+     */
+    explicit LruCache(size_t capacity) : capacity(capacity > 0 ? capacity : 1) { index.reserve(this->capacity); }
+
+    LruCache(const LruCache &) = delete;
+    LruCache &operator=(const LruCache &) = delete;
+
+    /**
+     * @brief Looks up a key and marks it as the most recently used
+     * @param value Receives a copy of the value if the key is held
+     * @return Whether the key is held
+     */
+    bool find(const K &key, V &value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            miss_count++;
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        value = it->second->second;
+        hit_count++;
+        return true;
+    }
+
+    /**
+     * @brief Holds a value as the most recently used, replacing any value already held for the key and forgetting the
+     * least recently used value if the cache is full
+     */
+    void insert(const K &key, V value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        if (entries.size() >= capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, std::move(value));
+        index.emplace(key, entries.begin());
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        index.clear();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    size_t getCapacity() const { return capacity; }
+    uint64_t hits() const { return hit_count; }
+    uint64_t misses() const { return miss_count; }
+};
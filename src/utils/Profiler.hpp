@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Records how long named scopes take on every thread and writes them out as a Chrome trace
+ * Each thread writes its scopes into a ring buffer of its own, so recording is two clock reads and a few atomic
+ * stores with no lock and no allocation. When a ring is full the oldest scopes are overwritten, so a trace holds the
+ * last EVENTS_PER_THREAD scopes of each thread. Writing a trace copies every ring while the threads keep recording.
+ * Every slot is a seqlock: its sequence is odd while the slot is being written and tells which scope it holds once
+ * it is even again, so the copy drops scopes that were overwritten or half written while it read them.
+ *
+ * Rings are kept until the program exits, so scopes of threads that have finished still end up in the trace. Scope
+ * and thread names are not copied and must be string literals.
+ *
+ * Use PROFILE_SCOPE and PROFILE_THREAD instead of calling this directly, they compile to nothing unless
+ * BETTERBLOX_PROFILE is defined.
+ */
+class Profiler {
+public:
+    constexpr static size_t EVENTS_PER_THREAD = 1 << 14; // Power of two
+
+    struct Event {
+        const char *name;
+        uint64_t start;    // Nanoseconds since the profiler started
+        uint64_t duration; // Nanoseconds
+    };
+
+private:
+    // Every field is atomic so a trace can read a slot while its thread overwrites it
+    struct Slot {
+        std::atomic<uint64_t> sequence{0}; // 2 * scope + 1 while scope is written, 2 * scope + 2 once it is done
+        std::atomic<const char *> name{nullptr};
+        std::atomic<uint64_t> start{0};
+        std::atomic<uint64_t> duration{0};
+    };
+
+    struct ThreadBuffer {
+        std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(EVENTS_PER_THREAD);
+        std::atomic<uint64_t> written{0}; // Scopes ever recorded, the next one goes in slot written % EVENTS_PER_THREAD
+        std::atomic<const char *> name{nullptr};
+        int id = 0;
+    };
+
+    static std::mutex &registryMutex();
+    static std::vector<std::unique_ptr<ThreadBuffer>> &registry();
+    static ThreadBuffer &threadBuffer();
+    static std::vector<Event> copyEvents(const ThreadBuffer &buffer);
+
+public:
+    static uint64_t now();
+    static void record(const char *name, uint64_t start, uint64_t end);
+    static void nameThread(const char *name);
+    static bool writeChromeTrace(const std::string &path);
+};
+
+/**
+ * @brief Records the time from its construction to the end of its scope
+ */
+class ProfileScope {
+private:
+    const char *name;
+    uint64_t start;
+
+public:
+    explicit ProfileScope(const char *name) : name(name), start(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(name, start, Profiler::now()); }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#ifdef BETTERBLOX_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::nameThread(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+inline std::mutex &Profiler::registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+inline std::vector<std::unique_ptr<Profiler::ThreadBuffer>> &Profiler::registry() {
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    return buffers;
+}
+
+/**
+ * @brief Ring of the calling thread, made the first time the thread records anything
+ */
+inline Profiler::ThreadBuffer &Profiler::threadBuffer() {
+    thread_local ThreadBuffer *buffer = [] {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto &buffers = registry();
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffers.back()->id = (int)buffers.size();
+        return buffers.back().get();
+    }();
+    return *buffer;
+}
+
+/**
+ * @brief Nanoseconds since the profiler was first used
+ */
+inline uint64_t Profiler::now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ * @brief Adds a scope to the ring of the calling thread
+ * @param name Name of the scope, a string literal
+ * @param start Time the scope started, from now()
+ * @param end Time the scope ended, from now()
+ */
+inline void Profiler::record(const char *name, uint64_t start, uint64_t end) {
+    ThreadBuffer &buffer = threadBuffer();
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    Slot &slot = buffer.slots[index & (EVENTS_PER_THREAD - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    // Keeps the fields below from becoming visible before the odd sequence
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(end - start, std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Names the calling thread in traces
+ * @param name Name of the thread, a string literal
+ */
+inline void Profiler::nameThread(const char *name) {
+    threadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Copies the scopes a ring holds, leaving out any its thread overwrote during the copy
+ */
+inline std::vector<Profiler::Event> Profiler::copyEvents(const ThreadBuffer &buffer) {
+    uint64_t end = buffer.written.load(std::memory_order_acquire);
+    uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+    std::vector<Event> events;
+    events.reserve(end - begin);
+    for (uint64_t i = begin; i < end; i++) {
+        const Slot &slot = buffer.slots[i & (EVENTS_PER_THREAD - 1)];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        Event event{slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed),
+                    slot.duration.load(std::memory_order_relaxed)};
+        // Keeps the field loads above from moving past the second read of the sequence
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+        // The slot of scope i is reused by scope i + EVENTS_PER_THREAD, which may have started during the read
+        if (before == after && before == 2 * i + 2) events.push_back(event);
+    }
+    return events;
+}
+
+/**
+ * @brief Writes every recorded scope of every thread as Chrome trace_event JSON, for chrome://tracing or Perfetto
+ * @param path File to write
+ * @return False if the file could not be written
+ */
+inline bool Profiler::writeChromeTrace(const std::string &path) {
+    std::ofstream ofs(path);
+    if (!ofs) return false;
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&] {
+        if (!first) ofs << ",";
+        first = false;
+        ofs << "\n";
+    };
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const auto &buffer : registry()) {
+        if (const char *name = buffer->name.load(std::memory_order_relaxed)) {
+            separate();
+            ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"args\":{\"name\":\"" << name << "\"}}";
+        }
+        for (const Event &event : copyEvents(*buffer)) {
+            separate();
+            ofs << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+                << ",\"ts\":" << event.start / 1000 << "." << event.start / 100 % 10
+                << ",\"dur\":" << event.duration / 1000 << "." << event.duration / 100 % 10 << "}";
+        }
+    }
+    ofs << "\n]}" << std::endl;
+    return (bool)ofs;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+
+/**
+ * @brief Fixed set of threads that run submitted jobs first in, first out
+ * The helpers parallelFor() hands to idle workers go to the front of the queue, ahead of submitted jobs, so its
+ * caller is not kept waiting behind them. Jobs that are still queued when the pool is destroyed are run before the
+ * threads exit, so queued saves are never lost.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    int idle = 0; // Workers waiting for a job
+
+    void run() {
+        PROFILE_THREAD("worker");
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            idle++;
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            idle--;
+            if (jobs.empty()) return;
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+public:
+    /**
+     * @brief Number of workers that leaves one core for the render thread
+     */
+    static unsigned defaultThreadCount() {
+        unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 1;
+    }
+
+    explicit WorkerPool(unsigned threads = defaultThreadCount()) {
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; i++) workers.emplace_back(&WorkerPool::run, this);
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) worker.join();
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    /**
+     * @brief Runs fn(0) to fn(count - 1) on the workers and the calling thread, and returns once all of them are done
+     * Only workers that are idle are asked to help, and their helper jobs go to the front of the queue, so helping
+     * never waits behind other jobs. When every worker is busy the calling thread does all the work itself. It takes
+     * work either way, so this can be called from a job running on this pool.
+     */
+    void parallelFor(int count, const std::function<void(int)> &fn) {
+        struct Shared {
+            std::atomic<int> next{0};
+            int done = 0;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto shared = std::make_shared<Shared>();
+        const std::function<void(int)> *work = &fn;
+        // Helpers that start after everything is taken return without touching fn, which may be gone by then
+        auto run = [shared, work, count] {
+            int ran = 0;
+            for (int i = shared->next++; i < count; i = shared->next++, ran++) (*work)(i);
+            if (ran == 0) return;
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->done += ran;
+            if (shared->done == count) shared->finished.notify_all();
+        };
+        int helpers;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            helpers = std::max(0, std::min(count - 1, idle - (int)jobs.size()));
+            for (int i = 0; i < helpers; i++) jobs.push_front(run);
+        }
+        for (int i = 0; i < helpers; i++) wake.notify_one();
+        run();
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        shared->finished.wait(lock, [&] { return shared->done == count; });
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size();
+    }
+
+    unsigned size() const {
+        return (unsigned)workers.size();
+    }
+};
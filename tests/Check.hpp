@@ -0,0 +1,20 @@
+#pragma once
+
+#include <iostream>
+
+/**
+ * @brief Number of failed checks since the tests started
+ */
+inline int &failedChecks() {
+    static int failed = 0;
+    return failed;
+}
+
+// Reports a failed condition with where it is and keeps going, so one run shows every failure
+#define CHECK(condition)                                                                                              \
+    do {                                                                                                              \
+        if (!(condition)) {                                                                                           \
+            failedChecks()++;                                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl;                \
+        }                                                                                                             \
+    } while (0)
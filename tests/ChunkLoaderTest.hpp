@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+
+#include "../src/ChunkLoader.hpp"
+#include "Check.hpp"
+
+/**
+ * @brief Checks that two chunks hold the same block everywhere
+ */
+inline bool sameBlocks(const Chunk &a, const Chunk &b) {
+    for (int y = 0; y < Chunk::HEIGHT; y++) {
+        for (int z = 0; z < Chunk::SIZE; z++) {
+            for (int x = 0; x < Chunk::SIZE; x++) {
+                if (a.get(x, y, z) != b.get(x, y, z)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Saves a chunk and reads it back
+ * @return Number of records the chunk was saved as
+ */
+inline uint64_t saveAndRead(const Chunk &chunk, Chunk &read) {
+    uint64_t bytes = ChunkLoader::stats().bytes_written;
+    ChunkLoader::saveChunk(chunk);
+    read = Chunk(chunk.getX(), chunk.getZ());
+    ChunkLoader::readFile(chunk.getX(), chunk.getZ(), read);
+    return (ChunkLoader::stats().bytes_written - bytes) / sizeof(BlockInfo);
+}
+
+/**
+ * @brief Chunks saved as vertical runs read back block for block, with tombstones and edits played over the runs
+ * ATTR bits 1-7 hold the run length minus one, so the longest run is 128 blocks, the full height of a chunk.
+ */
+inline void testChunkRuns() {
+    constexpr int SIZE = Chunk::SIZE;
+    Chunk read;
+
+    // Runs never cross columns, so a full column is the longest run there is and has to fit in one record
+    static_assert(Chunk::HEIGHT <= 128, "a full column no longer fits in the 7 bits of a run length");
+    Chunk column(-3, 5);
+    for (int y = 0; y < Chunk::HEIGHT; y++) column.set(4, y, 7, STONE);
+    CHECK(saveAndRead(column, read) == 1);
+    CHECK(sameBlocks(column, read));
+
+    // A run that breaks one block short of the top, and one that is a single block at the top
+    Chunk top(2, -4);
+    for (int y = 0; y < Chunk::HEIGHT - 1; y++) top.set(0, y, 0, GRASS);
+    top.set(0, Chunk::HEIGHT - 1, 0, SAND);
+    top.set(SIZE - 1, Chunk::HEIGHT - 1, SIZE - 1, SAND);
+    CHECK(saveAndRead(top, read) == 3);
+    CHECK(sameBlocks(top, read));
+
+    // A record whose run reaches past y = 127 stops at the top of its column instead of spilling anywhere
+    int world_x = 7 * SIZE + 3, world_z = -7 * SIZE + 9;
+    BlockInfo record = ChunkLoader::encodeBlock(glm::vec3(world_x, 100, world_z), WATER);
+    record.bits.attr = (uint64_t)(40 - 1) << 1;
+    ChunkLoader::writeChunk(7, -7, {record});
+    Chunk clipped(7, -7), expected(7, -7);
+    ChunkLoader::readFile(7, -7, clipped);
+    for (int y = 100; y < Chunk::HEIGHT; y++) expected.set(3, y, 9, WATER);
+    CHECK(sameBlocks(clipped, expected));
+
+    // Tombstones and single block edits played over runs, before and after the chunk is compacted
+    Chunk edited(-1, -1);
+    int origin_x = -SIZE, origin_z = -SIZE;
+    for (int z = 0; z < SIZE; z++) {
+        for (int x = 0; x < SIZE; x++) {
+            for (int y = 0; y < 64; y++) edited.set(x, y, z, y < 60 ? STONE : DIRT);
+        }
+    }
+    saveAndRead(edited, read);
+    auto remove = [&](int x, int y, int z) {
+        ChunkLoader::deleteBlock(glm::vec3(origin_x + x, y, origin_z + z), edited.get(x, y, z));
+        edited.set(x, y, z, AIR);
+    };
+    auto place = [&](int x, int y, int z, int block_type) {
+        ChunkLoader::placeCube(glm::vec3(origin_x + x, y, origin_z + z), block_type);
+        edited.set(x, y, z, block_type);
+    };
+    remove(0, 0, 0);    // Bottom of a run
+    remove(1, 30, 1);   // Middle of a run
+    remove(2, 59, 2);   // Last block of one run under the next
+    remove(3, 63, 3);   // Top of a run
+    place(1, 30, 1, SAND);
+    place(4, 64, 4, SAND); // On top of a run
+    remove(1, 30, 1);      // The edit itself, after the tombstone before it
+    read = Chunk(-1, -1);
+    ChunkLoader::readFile(-1, -1, read);
+    CHECK(sameBlocks(edited, read));
+
+    ChunkLoader::compactChunk(-1, -1);
+    read = Chunk(-1, -1);
+    ChunkLoader::readFile(-1, -1, read);
+    CHECK(sameBlocks(edited, read));
+}
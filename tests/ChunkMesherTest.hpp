@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <tuple>
+
+#include "../src/ChunkMesher.hpp"
+#include "Check.hpp"
+
+// Face of a block as (x, y, z, axis, front), mapped to the block type drawn on it
+using FaceMap = std::map<std::tuple<int, int, int, int, bool>, int>;
+
+/**
+ * @brief Faces a mesher without merging would draw, one per block side that is not against another block
+ */
+inline FaceMap naiveFaces(const Chunk &chunk, const ChunkNeighbours &neighbours) {
+    auto block = [&](int x, int y, int z) {
+        if (y < 0 || y >= Chunk::HEIGHT) return AIR;
+        if (x >= 0 && x < Chunk::SIZE && z >= 0 && z < Chunk::SIZE) return chunk.get(x, y, z);
+        const Chunk *next = x < 0 ? neighbours.neg_x : x >= Chunk::SIZE ? neighbours.pos_x
+                          : z < 0 ? neighbours.neg_z : neighbours.pos_z;
+        return next != nullptr ? next->get(Chunk::toLocal(x), y, Chunk::toLocal(z)) : AIR;
+    };
+    FaceMap faces;
+    chunk.forEachBlock([&](int x, int y, int z, int block_type) {
+        for (int axis = 0; axis < 3; axis++) {
+            for (bool front : {false, true}) {
+                int p[3] = {x, y, z};
+                p[axis] += front ? 1 : -1;
+                if (block(p[0], p[1], p[2]) == AIR) faces[{x, y, z, axis, front}] = block_type;
+            }
+        }
+    });
+    return faces;
+}
+
+/**
+ * @brief Splits every quad of a greedy mesh back into block faces
+ * @return False if two quads cover the same face
+ */
+inline bool meshFaces(const ChunkMesh &mesh, FaceMap &faces) {
+    bool overlap = false;
+    for (size_t quad = 0; quad < mesh.vertices.size(); quad += 6) {
+        const MeshVertex *corners = &mesh.vertices[quad];
+        float low[3], high[3];
+        for (int i = 0; i < 3; i++) low[i] = high[i] = (&corners[0].x)[i];
+        for (int c = 1; c < 6; c++) {
+            for (int i = 0; i < 3; i++) {
+                low[i] = std::min(low[i], (&corners[c].x)[i]);
+                high[i] = std::max(high[i], (&corners[c].x)[i]);
+            }
+        }
+        int axis = low[0] == high[0] ? 0 : low[1] == high[1] ? 1 : 2;
+        // The first triangle winds counter-clockwise seen from the side the face points to
+        float e1[3], e2[3];
+        for (int i = 0; i < 3; i++) {
+            e1[i] = (&corners[1].x)[i] - (&corners[0].x)[i];
+            e2[i] = (&corners[2].x)[i] - (&corners[0].x)[i];
+        }
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        bool front = e1[u] * e2[v] - e1[v] * e2[u] > 0;
+        int slice = (int)std::lround(low[axis] + (front ? -0.5f : 0.5f));
+        int block_type = (int)(corners[0].block >> 16);
+
+        for (int j = (int)std::lround(low[v] + 0.5f); j < (int)std::lround(high[v] + 0.5f); j++) {
+            for (int i = (int)std::lround(low[u] + 0.5f); i < (int)std::lround(high[u] + 0.5f); i++) {
+                int p[3];
+                p[axis] = slice, p[u] = i, p[v] = j;
+                auto [itr, inserted] = faces.try_emplace({p[0], p[1], p[2], axis, front}, block_type);
+                overlap |= !inserted;
+            }
+        }
+    }
+    return !overlap;
+}
+
+/**
+ * @brief Fills a chunk with random blocks, denser and with fewer types near the bottom so faces merge
+ */
+inline void fillRandom(Chunk &chunk, std::mt19937 &random, int height) {
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    for (int y = 0; y < height; y++) {
+        float density = 1.0f - (float)y / (float)height;
+        int types = 1 + y / 16;
+        for (int z = 0; z < Chunk::SIZE; z++) {
+            for (int x = 0; x < Chunk::SIZE; x++) {
+                if (chance(random) < density) chunk.set(x, y, z, (int)(random() % types));
+            }
+        }
+    }
+}
+
+/**
+ * @brief The greedy mesher draws exactly the faces the naive mesher draws, each once and with the same block type
+ */
+inline void testChunkMesher() {
+    std::mt19937 random(9);
+    for (int round = 0; round < 40; round++) {
+        int height = 1 + (int)(random() % Chunk::HEIGHT);
+        Chunk chunk(0, 0), pos_x(1, 0), neg_z(0, -1);
+        fillRandom(chunk, random, height);
+        fillRandom(pos_x, random, height);
+        fillRandom(neg_z, random, height);
+        ChunkNeighbours neighbours;
+        // Half the rounds have neighbours loaded on two sides, the faces against them must go
+        if (round % 2) {
+            neighbours.pos_x = &pos_x;
+            neighbours.neg_z = &neg_z;
+        }
+
+        ChunkMesh mesh = ChunkMesher::build(chunk, neighbours);
+        FaceMap expected = naiveFaces(chunk, neighbours), actual;
+        CHECK(mesh.vertices.size() == (size_t)mesh.quads * 6);
+        CHECK(meshFaces(mesh, actual));
+        CHECK(actual == expected);
+        CHECK((size_t)mesh.quads <= expected.size());
+    }
+
+    // A full layer merges into one quad per side
+    Chunk slab;
+    for (int z = 0; z < Chunk::SIZE; z++) {
+        for (int x = 0; x < Chunk::SIZE; x++) slab.set(x, 0, z, 0);
+    }
+    CHECK(ChunkMesher::build(slab).quads == 6);
+}
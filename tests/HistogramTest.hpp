@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "../src/FrameStats.hpp"
+#include "../src/utils/Histogram.hpp"
+#include "Check.hpp"
+
+/**
+ * @brief Checks that a percentile is at or above the real value and no more than one bucket width, 1/64, above it
+ */
+inline bool closeAbove(uint64_t value, uint64_t real) {
+    return value >= real && value - real <= real / 64;
+}
+
+/**
+ * @brief Percentiles of known distributions, exact below 128 and within a bucket above, and FrameStats::reset()
+ */
+inline void testHistogram() {
+    // Nothing recorded reads as 0 everywhere
+    Histogram empty;
+    CHECK(empty.count() == 0);
+    CHECK(empty.min() == 0 && empty.max() == 0 && empty.mean() == 0.0);
+    CHECK(empty.percentile(0) == 0 && empty.percentile(50) == 0 && empty.percentile(100) == 0);
+
+    // Values below 128 have a bucket each, so percentiles are exact
+    Histogram uniform;
+    for (uint64_t value = 1; value <= 100; value++) uniform.record(value);
+    CHECK(uniform.count() == 100);
+    CHECK(uniform.min() == 1 && uniform.max() == 100 && uniform.mean() == 50.5);
+    CHECK(uniform.percentile(50) == 50);
+    CHECK(uniform.percentile(95) == 95);
+    CHECK(uniform.percentile(99) == 99);
+    CHECK(uniform.percentile(100) == 100);
+    for (uint64_t value = 0; value < Histogram::SUB_BUCKETS; value++) {
+        Histogram single;
+        single.record(value);
+        CHECK(single.percentile(50) == value);
+    }
+
+    // A long tail only shows past the share of frames it takes up, and the max is always exact
+    Histogram skewed;
+    for (int i = 0; i < 990; i++) skewed.record(10);
+    for (int i = 0; i < 10; i++) skewed.record(5000);
+    CHECK(skewed.percentile(50) == 10);
+    CHECK(skewed.percentile(95) == 10);
+    CHECK(skewed.percentile(99) == 10);
+    CHECK(skewed.percentile(99.5) == 5000);
+    CHECK(skewed.max() == 5000);
+
+    // Larger values share buckets, so percentiles land on the top of the bucket of the real value
+    Histogram large;
+    for (uint64_t i = 1; i <= 10000; i++) large.record(i * 1000);
+    CHECK(closeAbove(large.percentile(50), 5000000));
+    CHECK(closeAbove(large.percentile(95), 9500000));
+    CHECK(closeAbove(large.percentile(99), 9900000));
+    CHECK(large.max() == 10000000);
+    CHECK(large.percentile(100) == 10000000);
+
+    // The largest values a uint64_t holds
+    Histogram huge;
+    uint64_t top = std::numeric_limits<uint64_t>::max();
+    huge.record(1ULL << 40);
+    huge.record(3ULL << 61);
+    huge.record(top);
+    CHECK(closeAbove(huge.percentile(10), 1ULL << 40));
+    CHECK(closeAbove(huge.percentile(50), 3ULL << 61));
+    CHECK(huge.percentile(99) == top);
+    CHECK(huge.max() == top);
+
+    // Merging the halves of a distribution gives the same percentiles as recording all of it
+    Histogram low, high;
+    for (uint64_t i = 1; i <= 5000; i++) low.record(i * 1000);
+    for (uint64_t i = 5001; i <= 10000; i++) high.record(i * 1000);
+    low.merge(high);
+    CHECK(low.count() == large.count());
+    CHECK(low.min() == large.min() && low.max() == large.max());
+    for (double percent : {1.0, 50.0, 95.0, 99.0}) CHECK(low.percentile(percent) == large.percentile(percent));
+
+    Histogram cleared = large;
+    cleared.reset();
+    CHECK(cleared.count() == 0 && cleared.max() == 0 && cleared.percentile(99) == 0);
+
+    // Every metric has a name in the report, and reset() clears every metric
+    FrameStats stats;
+    for (int i = 0; i < FrameStats::METRICS; i++) {
+        FrameStats::Metric metric = (FrameStats::Metric)i;
+        stats.record(metric, (uint64_t)(i + 1) * 100);
+        CHECK(FrameStats::metricName(metric) != nullptr);
+        if (FrameStats::metricName(metric) != nullptr)
+            CHECK(stats.report().find(FrameStats::metricName(metric)) != std::string::npos);
+    }
+    CHECK(stats.frames() == 1);
+    stats.reset();
+    CHECK(stats.frames() == 0);
+    for (int i = 0; i < FrameStats::METRICS; i++) {
+        FrameStats::Metric metric = (FrameStats::Metric)i;
+        CHECK(stats.get(metric).count() == 0);
+        CHECK(stats.percentile(metric, 99) == 0);
+    }
+}
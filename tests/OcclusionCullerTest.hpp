@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../src/ChunkMap.hpp"
+#include "../src/OcclusionCuller.hpp"
+#include "Check.hpp"
+
+/**
+ * @brief Marks every chunk a straight ray from the camera passes through before it hits a block
+ * Walks the block grid one block at a time, block (x, y, z) filling [x, x + 1) on every axis like the culler counts
+ * positions. The chunk of the block the ray stops at is seen too.
+ */
+inline void castRay(const ChunkMap<Chunk> &chunks, glm::vec3 origin, glm::vec3 direction, int render_distance,
+                    ChunkMap<bool> &seen) {
+    int center_x = ChunkLoader::chunkCoord((int)std::floor(origin.x));
+    int center_z = ChunkLoader::chunkCoord((int)std::floor(origin.z));
+    int cell[3] = {(int)std::floor(origin.x), (int)std::floor(origin.y), (int)std::floor(origin.z)};
+    int step[3];
+    float next[3], delta[3];
+    for (int i = 0; i < 3; i++) {
+        step[i] = direction[i] > 0 ? 1 : -1;
+        delta[i] = direction[i] != 0 ? std::abs(1.0f / direction[i]) : INFINITY;
+        float edge = direction[i] > 0 ? (float)cell[i] + 1 - origin[i] : origin[i] - (float)cell[i];
+        next[i] = direction[i] != 0 ? edge * delta[i] : INFINITY;
+    }
+    while (true) {
+        int chunk_x = ChunkLoader::chunkCoord(cell[0]), chunk_z = ChunkLoader::chunkCoord(cell[2]);
+        if (cell[1] < 0 || cell[1] >= Chunk::HEIGHT) return;
+        if (std::abs(chunk_x - center_x) > render_distance || std::abs(chunk_z - center_z) > render_distance) return;
+        const Chunk *chunk = chunks.find(chunk_x, chunk_z);
+        if (chunk == nullptr) return;
+        seen.insert(chunk_x, chunk_z, true);
+        if (chunk->get(Chunk::toLocal(cell[0]), cell[1], Chunk::toLocal(cell[2])) != AIR) return;
+
+        int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+        cell[axis] += step[axis];
+        next[axis] += delta[axis];
+    }
+}
+
+/**
+ * @brief The culler never hides a chunk that a ray from the camera reaches through air, on random terrain with caves
+ */
+inline void testOcclusionCuller() {
+    constexpr int RENDER_DISTANCE = 3;
+    constexpr int RAYS = 20000;
+    std::mt19937 random(15);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    int culled = 0;
+
+    for (int scene = 0; scene < 12; scene++) {
+        // Ground at a random height with more air pockets in later scenes, so some scenes are open caves
+        ChunkMap<Chunk> chunks;
+        OcclusionCuller culler;
+        float pockets = 0.02f + 0.04f * (float)(scene % 4);
+        for (int chunk_x = -RENDER_DISTANCE; chunk_x <= RENDER_DISTANCE; chunk_x++) {
+            for (int chunk_z = -RENDER_DISTANCE; chunk_z <= RENDER_DISTANCE; chunk_z++) {
+                Chunk chunk(chunk_x, chunk_z);
+                for (int z = 0; z < Chunk::SIZE; z++) {
+                    for (int x = 0; x < Chunk::SIZE; x++) {
+                        int ground = 48 + (int)(random() % 32);
+                        for (int y = 0; y < ground; y++) {
+                            if (unit(random) >= pockets) chunk.set(x, y, z, 1);
+                        }
+                    }
+                }
+                culler.update(chunk);
+                chunks.insert(chunk_x, chunk_z, std::move(chunk));
+            }
+        }
+
+        // Half the cameras are underground, cleared out a little so they are not stuck in a block
+        glm::vec3 camera(unit(random) * Chunk::SIZE, scene % 2 ? 20.0f + unit(random) * 20.0f : 100.0f,
+                         unit(random) * Chunk::SIZE);
+        Chunk *home = chunks.find(0, 0);
+        for (int y = -1; y <= 1; y++) {
+            for (int z = -1; z <= 1; z++) {
+                for (int x = -1; x <= 1; x++)
+                    home->set((int)camera.x + x, (int)camera.y + y, (int)camera.z + z, AIR);
+            }
+        }
+        culler.update(*home);
+        culler.search(camera, RENDER_DISTANCE);
+
+        ChunkMap<bool> seen;
+        for (int ray = 0; ray < RAYS; ray++) {
+            glm::vec3 direction(normal(random), normal(random), normal(random));
+            castRay(chunks, camera, direction, RENDER_DISTANCE, seen);
+        }
+        seen.forEach([&](int chunk_x, int chunk_z, bool) { CHECK(culler.isVisible(chunk_x, chunk_z)); });
+        chunks.forEach([&](int chunk_x, int chunk_z, const Chunk &) { culled += !culler.isVisible(chunk_x, chunk_z); });
+    }
+    // The underground scenes with few pockets must hide something, or the test checks nothing
+    CHECK(culled > 0);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../src/RegionFile.hpp"
+#include "Check.hpp"
+
+/**
+ * @brief Reads every byte of a file
+ */
+inline std::vector<char> fileBytes(const std::string &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Writes a file holding exactly the bytes given
+ */
+inline void writeBytes(const std::string &path, const std::vector<char> &bytes) {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(bytes.data(), bytes.size());
+}
+
+/**
+ * @brief Region files with a header that cannot be read are never written over
+ * Covers a file of garbage, a file too short to hold the chunk table and a region of a newer version, each opened
+ * and then written to both ways. The file has to keep its original bytes.
+ */
+inline void testRegionHeader() {
+    const char payload[] = "chunk";
+    std::vector<char> read;
+
+    std::vector<char> garbage(64 * 1024);
+    for (size_t i = 0; i < garbage.size(); i++) garbage[i] = (char)(i * 31 + 7);
+
+    // A valid region, then the same file claiming a newer version, which only differs in the version field
+    std::filesystem::remove("valid.bin");
+    {
+        RegionFile valid("valid.bin");
+        CHECK(valid.writeChunk(1, 2, payload, sizeof(payload)));
+    }
+    std::vector<char> newer = fileBytes("valid.bin");
+    CHECK(newer.size() > 8);
+    if (newer.size() > 8) newer[4]++;
+
+    std::vector<char> short_header(garbage.begin(), garbage.begin() + 100);
+    short_header[0] = 'B', short_header[1] = 'B', short_header[2] = 'R', short_header[3] = 'G';
+
+    const std::vector<char> *bad_files[] = {&garbage, &short_header, &newer};
+    for (const std::vector<char> *bytes : bad_files) {
+        writeBytes("bad.bin", *bytes);
+        {
+            RegionFile region("bad.bin");
+            CHECK(!region.isUsable());
+            CHECK(!region.hasChunk(1, 2));
+            CHECK(!region.readChunk(1, 2, read));
+            CHECK(!region.writeChunk(0, 0, payload, sizeof(payload)));
+            CHECK(!region.appendChunk(3, 3, payload, sizeof(payload)));
+        }
+        CHECK(fileBytes("bad.bin") == *bytes);
+    }
+
+    // A region that was never written is still created on the first write
+    std::filesystem::remove("fresh.bin");
+    RegionFile fresh("fresh.bin");
+    CHECK(fresh.isUsable());
+    CHECK(fresh.writeChunk(0, 0, payload, sizeof(payload)));
+    CHECK(fresh.readChunk(0, 0, read) && read.size() == sizeof(payload));
+}
@@ -0,0 +1,50 @@
+// Checks parts of the game against simple reference versions of them, on random chunks with fixed seeds. Runs every
+// test, or only the one named, and exits with 1 if any check failed. Files are written to a scratch directory under
+// the system temp directory, which is emptied first.
+// Usage: betterblox_tests [test name]
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "Check.hpp"
+#include "ChunkLoaderTest.hpp"
+#include "ChunkMesherTest.hpp"
+#include "HistogramTest.hpp"
+#include "OcclusionCullerTest.hpp"
+#include "RegionFileTest.hpp"
+
+struct Test {
+    const char *name;
+    void (*run)();
+};
+
+constexpr Test TESTS[] = {
+    {"chunk_mesher", testChunkMesher},
+    {"occlusion_culler", testOcclusionCuller},
+    {"chunk_runs", testChunkRuns},
+    {"region_header", testRegionHeader},
+    {"histogram", testHistogram},
+};
+
+int main(int argc, char **argv) {
+    const char *only = argc > 1 ? argv[1] : nullptr;
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "betterblox_tests";
+    std::filesystem::remove_all(scratch);
+    std::filesystem::create_directories(scratch);
+    std::filesystem::current_path(scratch);
+
+    int ran = 0;
+    for (const Test &test : TESTS) {
+        if (only != nullptr && std::strcmp(only, test.name) != 0) continue;
+        int failed = failedChecks();
+        test.run();
+        std::cout << (failedChecks() == failed ? "passed " : "FAILED ") << test.name << std::endl;
+        ran++;
+    }
+    if (ran == 0) {
+        std::cerr << "Unknown test: " << only << std::endl;
+        return 1;
+    }
+    return failedChecks() == 0 ? 0 : 1;
+}